@@ -0,0 +1,159 @@
+#include "cli.h"
+#include "pakscanner.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDebug>
+
+bool isCommandLineInvocation(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--scan") == 0 || qstrcmp(argv[i], "--db-summary") == 0 || qstrcmp(argv[i], "--build-vanilla") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool writeOutput(const QString &path, const QByteArray &data) {
+    QFile file(path);
+    bool opened = path == "-" ? file.open(stdout, QIODevice::WriteOnly) : file.open(QIODevice::WriteOnly);
+    if (!opened) {
+        qCritical().noquote() << "Unable to write" << path;
+        return false;
+    }
+    file.write(data);
+    return true;
+}
+
+static QByteArray databaseSummary(ScanDatabase &database) {
+    QHash<QString, QJsonArray> modules;
+    for (const ModModule &module : database.mod_modules()) {
+        modules[module.mod_path].append(module.meta.to_json());
+    }
+
+    QJsonArray mods;
+    for (const ModSummary &summary : database.mod_summaries()) {
+        QJsonObject mod;
+        mod["name"] = summary.name;
+        mod["path"] = summary.path;
+        mod["paks"] = summary.paks;
+        mod["languages"] = QJsonArray::fromStringList(summary.languages);
+        mod["strings"] = summary.strings;
+        mod["has_mcm"] = summary.has_mcm;
+        mod["modules"] = modules.value(summary.path);
+        mods.append(mod);
+    }
+    return QJsonDocument(mods).toJson(QJsonDocument::Indented);
+}
+
+int runCommandLine(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Defakof's Modding Tools - headless scanner");
+    parser.addHelpOption();
+    QCommandLineOption scanOption("scan", "Mod folder to scan (repeatable).", "folder");
+    QCommandLineOption managerOption("manager", "Mod manager layout: Mod Organizer 2, Vortex or BG3 Mod Manager (pass the game's Mods folder to --scan).", "name", "Mod Organizer 2");
+    QCommandLineOption divineOption("divine", "Path to divine.exe.", "path");
+    QCommandLineOption divineVersionOption("divine-version", "ExportTool version from the shared tool cache.", "version");
+    QCommandLineOption tempOption("temp", "Temporary extraction folder.", "path");
+    QCommandLineOption tmpfsOption("tmpfs", "Place temporary files on tmpfs when available.");
+    QCommandLineOption metricsOption("metrics-json", "Write scan metrics as JSON ('-' for stdout).", "file");
+    QCommandLineOption logOption("log", "Write the full scan log ('-' for stdout).", "file");
+    QCommandLineOption resumeOption("resume", "Continue an interrupted scan from its checkpoint.");
+    QCommandLineOption vanillaOption("build-vanilla", "Index the game's own localization packages under the Data folder.", "folder");
+    QCommandLineOption dbSummaryOption("db-summary", "Write per-mod results from the scan database as JSON ('-' for stdout).", "file");
+    parser.addOption(scanOption);
+    parser.addOption(managerOption);
+    parser.addOption(divineOption);
+    parser.addOption(divineVersionOption);
+    parser.addOption(tempOption);
+    parser.addOption(tmpfsOption);
+    parser.addOption(metricsOption);
+    parser.addOption(logOption);
+    parser.addOption(resumeOption);
+    parser.addOption(dbSummaryOption);
+    parser.addOption(vanillaOption);
+    parser.process(app);
+
+    PakScanner scanner;
+    if (parser.isSet(vanillaOption)) {
+        QString error;
+        if (!scanner.build_vanilla_baseline(parser.value(vanillaOption), error)) {
+            qCritical().noquote() << error;
+            return 1;
+        }
+        qInfo().noquote() << scanner.vanilla_baseline().entry_count() << "vanilla strings indexed";
+    }
+    if (!parser.isSet(scanOption)) {
+        // Query only, answer from the results of earlier scans
+        if (parser.isSet(dbSummaryOption)) {
+            return writeOutput(parser.value(dbSummaryOption), databaseSummary(scanner.scan_database())) ? 0 : 1;
+        }
+        return 0;
+    }
+    if (parser.isSet(divineOption)) {
+        scanner.set_divine_path(parser.value(divineOption));
+    }
+    if (parser.isSet(divineVersionOption) && !scanner.use_divine_version(parser.value(divineVersionOption))) {
+        qCritical().noquote() << "ExportTool" << parser.value(divineVersionOption) << "is not in the tool cache";
+        return 1;
+    }
+    if (parser.isSet(tmpfsOption)) {
+        scanner.set_prefer_tmpfs(true);
+    }
+    if (parser.isSet(tempOption)) {
+        scanner.set_temp_path(parser.value(tempOption));
+    }
+
+    QObject::connect(&scanner, &PakScanner::progress_updated, &app, [](const QString &message) {
+        qInfo().noquote() << message;
+    });
+
+    if (!scanner.checkDivine()) {
+        qCritical() << "Divine executable not found, use --divine to point at it";
+        return 1;
+    }
+
+    int exitCode = 0;
+    // scan_finished is emitted by the last scan worker; queue it to the main thread
+    QObject::connect(&scanner, &PakScanner::scan_finished, &app, [&](bool completed) {
+        if (parser.isSet(metricsOption)) {
+            QJsonDocument json(scanner.scan_metrics().to_json());
+            if (!writeOutput(parser.value(metricsOption), json.toJson(QJsonDocument::Indented))) {
+                exitCode = 1;
+            }
+        }
+        if (parser.isSet(logOption)) {
+            QByteArray log = scanner.scan_progress()->full_log().join("\n").toUtf8() + "\n";
+            if (!writeOutput(parser.value(logOption), log)) {
+                exitCode = 1;
+            }
+        }
+        if (parser.isSet(dbSummaryOption)) {
+            if (!writeOutput(parser.value(dbSummaryOption), databaseSummary(scanner.scan_database()))) {
+                exitCode = 1;
+            }
+        }
+        const ProgressAggregator *progress = scanner.scan_progress();
+        qInfo().noquote() << QString("%1 events, %2 errors").arg(progress->event_count()).arg(progress->error_count());
+        if (progress->error_count() > 0) {
+            for (const QString &event : progress->recent_events()) {
+                if (event.startsWith("[error] ")) {
+                    qWarning().noquote() << event;
+                }
+            }
+        }
+        if (!completed) {
+            exitCode = 2;
+        }
+        app.quit();
+    });
+
+    scanner.scan_mods(parser.values(scanOption), parser.value(managerOption), parser.isSet(resumeOption));
+    if (!scanner.is_scanning()) {
+        return 1;
+    }
+    app.exec();
+    return exitCode;
+}
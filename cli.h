@@ -0,0 +1,8 @@
+#ifndef CLI_H
+#define CLI_H
+
+// Headless entry point, used when DMT is started with scan options instead of the GUI.
+bool isCommandLineInvocation(int argc, char *argv[]);
+int runCommandLine(int argc, char *argv[]);
+
+#endif
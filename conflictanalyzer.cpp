@@ -0,0 +1,210 @@
+#include "conflictanalyzer.h"
+
+ConflictAnalyzer::ConflictAnalyzer() {
+}
+
+void ConflictAnalyzer::clear() {
+    section.clear();
+    current_order.clear();
+    mod_names.clear();
+    mod_ids.clear();
+    ranks.clear();
+    mod_keys.clear();
+    mod_stats.clear();
+    keys.clear();
+    providers.clear();
+    winners.clear();
+}
+
+int ConflictAnalyzer::mod_id(const QString &name) {
+    auto it = mod_ids.constFind(name);
+    if (it != mod_ids.constEnd()) {
+        return it.value();
+    }
+    int id = int(mod_names.size());
+    mod_names << name;
+    mod_ids.insert(name, id);
+    ranks << unranked;
+    mod_keys << QVector<int>();
+    mod_stats << ModStats();
+    return id;
+}
+
+void ConflictAnalyzer::build(const LocaSnapshot &snapshot, const QString &language,
+                             const QHash<QString, QSet<QByteArray>> &mod_sources, const QStringList &order) {
+    clear();
+    section = language;
+
+    // The same pak can ship in several mods, so a source maps to a list of mods
+    QByteArrayList sources = snapshot.sources();
+    QHash<QByteArray, int> source_index;
+    for (int i = 0; i < sources.size(); ++i) {
+        source_index.insert(sources[i], i);
+    }
+    QVector<QVector<int>> source_mods(sources.size());
+    for (auto mod = mod_sources.constBegin(); mod != mod_sources.constEnd(); ++mod) {
+        int id = mod_id(mod.key());
+        for (const QByteArray &fingerprint : mod.value()) {
+            auto index = source_index.constFind(fingerprint);
+            if (index != source_index.constEnd()) {
+                source_mods[index.value()] << id;
+            }
+        }
+    }
+
+    // Entries arrive sorted by key, so each key's providers are adjacent
+    QByteArray current_key;
+    QVector<int> current_providers;
+    auto flush = [this, &current_key, &current_providers]() {
+        if (current_providers.size() > 1) {
+            int key = int(keys.size());
+            keys << current_key;
+            providers << current_providers;
+            winners << -1;
+            for (int mod : current_providers) {
+                mod_keys[mod] << key;
+            }
+        }
+        current_providers.clear();
+    };
+    snapshot.for_each_key(language, [&](quint32 source, QByteArrayView key) {
+        if (current_providers.isEmpty() || LocaSnapshot::compare_keys(key, current_key) != 0) {
+            flush();
+            current_key = key.toByteArray();
+        }
+        if (source < quint32(source_mods.size())) {
+            for (int mod : source_mods[int(source)]) {
+                if (!current_providers.contains(mod)) {
+                    current_providers << mod;
+                }
+            }
+        }
+    });
+    flush();
+
+    set_order(order);
+}
+
+void ConflictAnalyzer::apply_key(int key, int sign) {
+    int winner = -1;
+    int ranked = 0;
+    for (int mod : providers[key]) {
+        if (ranks[mod] == unranked) {
+            continue;  // disabled mods are not loaded at all
+        }
+        ranked++;
+        if (winner < 0 || ranks[mod] < ranks[winner]) {
+            winner = mod;
+        }
+    }
+    if (ranked < 2) {
+        winner = -1;
+    }
+    winners[key] = sign > 0 ? winner : -1;
+    if (winner < 0) {
+        return;
+    }
+
+    for (int mod : providers[key]) {
+        if (mod == winner) {
+            mod_stats[mod].overrides += sign;
+        } else if (ranks[mod] != unranked) {
+            mod_stats[mod].shadowed += sign;
+        }
+    }
+}
+
+void ConflictAnalyzer::recompute_all() {
+    for (ModStats &stats : mod_stats) {
+        stats = ModStats();
+    }
+    for (int key = 0; key < keys.size(); ++key) {
+        apply_key(key, 1);
+    }
+}
+
+int ConflictAnalyzer::set_order(const QStringList &order) {
+    if (order == current_order) {
+        return 0;
+    }
+
+    // A single drag-and-drop shows up as one rotated window of the list
+    int moved = -1;
+    int first = 0;
+    int last = int(order.size()) - 1;
+    if (order.size() == current_order.size()) {
+        while (first <= last && order[first] == current_order[first]) {
+            ++first;
+        }
+        while (last >= first && order[last] == current_order[last]) {
+            --last;
+        }
+        if (first < last) {
+            if (order[first] == current_order[last] && order.mid(first + 1, last - first) == current_order.mid(first, last - first)) {
+                moved = mod_ids.value(order[first], -1);
+            } else if (order[last] == current_order[first] && order.mid(first, last - first) == current_order.mid(first + 1, last - first)) {
+                moved = mod_ids.value(order[last], -1);
+            }
+        }
+    }
+
+    current_order = order;
+    if (moved >= 0) {
+        for (int key : mod_keys[moved]) {
+            apply_key(key, -1);
+        }
+        for (int rank = first; rank <= last; ++rank) {
+            ranks[mod_id(order[rank])] = rank;
+        }
+        for (int key : mod_keys[moved]) {
+            apply_key(key, 1);
+        }
+        return int(mod_keys[moved].size());
+    }
+
+    for (int &rank : ranks) {
+        rank = unranked;
+    }
+    for (int rank = 0; rank < order.size(); ++rank) {
+        ranks[mod_id(order[rank])] = rank;
+    }
+    recompute_all();
+    return int(keys.size());
+}
+
+QString ConflictAnalyzer::language() const {
+    return section;
+}
+
+int ConflictAnalyzer::conflict_count() const {
+    int count = 0;
+    for (int winner : winners) {
+        if (winner >= 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+ConflictAnalyzer::ModStats ConflictAnalyzer::stats(const QString &mod) const {
+    int id = mod_ids.value(mod, -1);
+    return id < 0 ? ModStats() : mod_stats[id];
+}
+
+QVector<ConflictAnalyzer::Conflict> ConflictAnalyzer::shadowed(const QString &mod, int limit) const {
+    QVector<Conflict> result;
+    int id = mod_ids.value(mod, -1);
+    if (id < 0 || ranks[id] == unranked) {
+        return result;
+    }
+    for (int key : mod_keys[id]) {
+        int winner = winners[key];
+        if (winner >= 0 && winner != id) {
+            result << Conflict{keys[key], mod_names[winner]};
+            if (result.size() == limit) {
+                break;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef CONFLICTANALYZER_H
+#define CONFLICTANALYZER_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "locasnapshot.h"
+
+// Works out, for every contentuid defined by more than one mod in a
+// language, which mod wins under the modlist.txt priority order (first line
+// wins), and which mods' strings are shadowed as a result.
+//
+// Providers are stored per key, so reordering is incremental: moving a single
+// mod cannot change the relative order of any other pair, and only the keys
+// that mod defines are recomputed.
+class ConflictAnalyzer {
+public:
+    struct ModStats {
+        int overrides = 0;  // strings of this mod that win over another mod
+        int shadowed = 0;   // strings of this mod hidden by a higher priority mod
+    };
+
+    struct Conflict {
+        QByteArray key;
+        QString winner;
+    };
+
+    ConflictAnalyzer();
+    void clear();
+    // mod_sources maps mod names to their pak fingerprints; order lists mods
+    // highest priority first, as in modlist.txt.
+    void build(const LocaSnapshot &snapshot, const QString &language,
+               const QHash<QString, QSet<QByteArray>> &mod_sources, const QStringList &order);
+    // Returns the number of keys that had to be recomputed.
+    int set_order(const QStringList &order);
+
+    QString language() const;
+    int conflict_count() const;
+    ModStats stats(const QString &mod) const;
+    QVector<Conflict> shadowed(const QString &mod, int limit = 100) const;
+
+private:
+    static const int unranked = 0x7fffffff;
+
+    int mod_id(const QString &name);
+    void apply_key(int key, int sign);
+    void recompute_all();
+
+    QString section;
+    QStringList current_order;
+    QVector<QString> mod_names;
+    QHash<QString, int> mod_ids;
+    QVector<int> ranks;           // per mod, 0 is the highest priority
+    QVector<QVector<int>> mod_keys;
+    QVector<ModStats> mod_stats;
+    QVector<QByteArray> keys;
+    QVector<QVector<int>> providers;  // per key, only keys with two or more
+    QVector<int> winners;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "divineversionresolver.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QDebug>
+
+DivineVersionResolver::DivineVersionResolver(QNetworkAccessManager *manager, const QString &cache_path, QObject *parent)
+    : QObject(parent), network_manager(manager), pending_reply(nullptr), cache_file(cache_path),
+      tags_url("https://api.github.com/repos/Norbyte/lslib/releases"), max_age(60 * 60) {
+    load_cache();
+}
+
+void DivineVersionResolver::set_tags_url(const QString &url) {
+    tags_url = url;
+}
+
+void DivineVersionResolver::set_max_age(qint64 seconds) {
+    max_age = seconds;
+}
+
+QString DivineVersionResolver::cached_version() const {
+    return version;
+}
+
+QByteArray DivineVersionResolver::asset_sha256(const QString &version, const QString &asset_name) const {
+    QString tag = version.startsWith('v') ? version : "v" + version;
+    const QJsonArray releases = QJsonDocument::fromJson(body).array();
+    for (const QJsonValue &release : releases) {
+        if (release.toObject()["tag_name"].toString() != tag) {
+            continue;
+        }
+        const QJsonArray assets = release.toObject()["assets"].toArray();
+        for (const QJsonValue &asset : assets) {
+            QString digest = asset.toObject()["digest"].toString();
+            if (asset.toObject()["name"].toString() == asset_name && digest.startsWith("sha256:")) {
+                return digest.mid(7).toLatin1().toLower();
+            }
+        }
+    }
+    return QByteArray();
+}
+
+bool DivineVersionResolver::is_stale() const {
+    return version.isEmpty() || !validated_at.isValid() || validated_at.secsTo(QDateTime::currentDateTimeUtc()) > max_age;
+}
+
+bool DivineVersionResolver::is_refreshing() const {
+    return pending_reply != nullptr;
+}
+
+void DivineVersionResolver::refresh_if_stale() {
+    if (is_stale()) {
+        refresh();
+    }
+}
+
+void DivineVersionResolver::refresh() {
+    if (pending_reply) {
+        return;  // The answer of the running request will be emitted
+    }
+
+    QUrl url(tags_url);
+    qInfo() << "Fetching latest Divine version from:" << url.toString();
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setTransferTimeout(5000);
+    if (!etag.isEmpty() && !body.isEmpty()) {
+        request.setRawHeader("If-None-Match", etag);
+    }
+
+    pending_reply = network_manager->get(request);
+    QNetworkReply *reply = pending_reply;
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        on_reply_finished(reply);
+    });
+}
+
+void DivineVersionResolver::on_reply_finished(QNetworkReply *reply) {
+    pending_reply = nullptr;
+    reply->deleteLater();
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 304) {
+        validated_at = QDateTime::currentDateTimeUtc();
+        save_cache();
+        emit version_resolved(version);
+        return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qWarning() << "Error fetching latest version:" << reply->errorString();
+        emit resolve_failed(reply->errorString());
+        return;
+    }
+
+    QByteArray response = reply->readAll();
+    QString latest = version_from_tags(response);
+    if (latest.isEmpty()) {
+        emit resolve_failed("No tags in response from " + tags_url);
+        return;
+    }
+
+    body = response;
+    etag = reply->rawHeader("ETag");
+    version = latest;
+    validated_at = QDateTime::currentDateTimeUtc();
+    save_cache();
+    emit version_resolved(version);
+}
+
+QString DivineVersionResolver::version_from_tags(const QByteArray &response) {
+    // Newest first; skip pre-releases. A cache from the tags endpoint only has "name".
+    const QJsonArray releases = QJsonDocument::fromJson(response).array();
+    for (const QJsonValue &value : releases) {
+        QJsonObject release = value.toObject();
+        if (release.contains("tag_name")) {
+            if (!release["prerelease"].toBool() && !release["draft"].toBool()) {
+                return release["tag_name"].toString();
+            }
+        } else if (release.contains("name")) {
+            return release["name"].toString();
+        }
+    }
+    return QString();
+}
+
+void DivineVersionResolver::load_cache() {
+    QFile file(cache_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    body = json["body"].toString().toUtf8();
+    etag = json["etag"].toString().toLatin1();
+    validated_at = QDateTime::fromString(json["validated_at"].toString(), Qt::ISODate);
+    version = version_from_tags(body);
+}
+
+void DivineVersionResolver::save_cache() {
+    QJsonObject json;
+    json["body"] = QString::fromUtf8(body);
+    json["etag"] = QString::fromLatin1(etag);
+    json["validated_at"] = validated_at.toString(Qt::ISODate);
+
+    QSaveFile file(cache_file);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef DIVINEVERSIONRESOLVER_H
+#define DIVINEVERSIONRESOLVER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// Resolves the latest lslib release tag without blocking. The GitHub releases
+// response is cached on disk together with its ETag; the cached answer is
+// returned immediately and revalidated in the background with If-None-Match.
+// The same response carries the SHA-256 digests of the release assets.
+class DivineVersionResolver : public QObject {
+    Q_OBJECT
+
+public:
+    DivineVersionResolver(QNetworkAccessManager *manager, const QString &cache_path, QObject *parent = nullptr);
+    void set_tags_url(const QString &url);
+    void set_max_age(qint64 seconds);
+
+    QString cached_version() const;
+    // Lowercase hex digest GitHub published for a release asset, or empty.
+    QByteArray asset_sha256(const QString &version, const QString &asset_name) const;
+    bool is_stale() const;
+    bool is_refreshing() const;
+
+signals:
+    void version_resolved(const QString &version);
+    void resolve_failed(const QString &error);
+
+public slots:
+    void refresh();
+    void refresh_if_stale();
+
+private:
+    void load_cache();
+    void save_cache();
+    void on_reply_finished(QNetworkReply *reply);
+    static QString version_from_tags(const QByteArray &body);
+
+    QNetworkAccessManager *network_manager;
+    QNetworkReply *pending_reply;
+    QString cache_file;
+    QString tags_url;
+    qint64 max_age;
+    QByteArray etag;
+    QByteArray body;
+    QString version;
+    QDateTime validated_at;
+};
+
+#endif
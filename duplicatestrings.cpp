@@ -0,0 +1,236 @@
+#include "duplicatestrings.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QMutexLocker>
+#include <algorithm>
+
+DuplicateStrings::DuplicateStrings() : unique_count(0) {
+}
+
+void DuplicateStrings::clear() {
+    indexed.reset();
+    section.clear();
+    entry_hashes.clear();
+    for (int s = 0; s < shard_count; ++s) {
+        shards[s].clear();
+    }
+    unique_count = 0;
+}
+
+quint64 DuplicateStrings::hash(const char *text, qsizetype length) {
+    // FNV-1a over the text with leading/trailing whitespace dropped and inner
+    // runs collapsed to one space, so no normalised copy is ever made.
+    quint64 h = 14695981039346656037ULL;
+    bool started = false;
+    bool pending_space = false;
+    for (qsizetype i = 0; i < length; ++i) {
+        uchar c = uchar(text[i]);
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            pending_space = started;
+            continue;
+        }
+        if (pending_space) {
+            h = (h ^ uchar(' ')) * 1099511628211ULL;
+            pending_space = false;
+        }
+        h = (h ^ c) * 1099511628211ULL;
+        started = true;
+    }
+
+    // Final avalanche so the top bits are good enough to pick a shard
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+bool DuplicateStrings::equal_normalised(QByteArrayView a, QByteArrayView b) {
+    // Same normalisation as hash(): trimmed, inner whitespace runs as one space
+    auto is_space = [](char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    };
+    qsizetype i = 0;
+    qsizetype j = 0;
+    for (;;) {
+        qsizetype a_run = i;
+        qsizetype b_run = j;
+        while (i < a.size() && is_space(a[i])) {
+            ++i;
+        }
+        while (j < b.size() && is_space(b[j])) {
+            ++j;
+        }
+        bool a_space = i > a_run && a_run > 0;
+        bool b_space = j > b_run && b_run > 0;
+        if (i == a.size() || j == b.size()) {
+            return i == a.size() && j == b.size();
+        }
+        if (a_space != b_space || a[i] != b[j]) {
+            return false;
+        }
+        ++i;
+        ++j;
+    }
+}
+
+int DuplicateStrings::shard_of(quint64 hash) {
+    return int(hash >> (64 - shard_bits));
+}
+
+void DuplicateStrings::build(const QSharedPointer<const LocaSnapshot> &snapshot, const QString &language, int threads) {
+    clear();
+    indexed = snapshot;
+    section = language;
+    int total_entries = snapshot->entry_count(language);
+    if (total_entries == 0) {
+        return;
+    }
+    entry_hashes.resize(total_entries);
+
+    if (threads <= 0) {
+        threads = QThread::idealThreadCount();
+    }
+    int chunks = qMax(1, qMin(threads * 4, total_entries / 4096));
+    int chunk_size = (total_entries + chunks - 1) / chunks;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    QMutex shard_locks[shard_count];
+    quint64 *hashes = entry_hashes.data();
+
+    for (int begin = 0; begin < total_entries; begin += chunk_size) {
+        int end = qMin(total_entries, begin + chunk_size);
+        pool.start([&, begin, end]() {
+            QVector<Item> local[shard_count];
+            snapshot->for_each_in(language, begin, end, [&](int index, QByteArrayView, QByteArrayView text) {
+                quint64 h = hash(text.data(), text.size());
+                hashes[index] = h;
+                local[shard_of(h)] << Item{h, quint32(index)};
+            });
+            for (int s = 0; s < shard_count; ++s) {
+                if (!local[s].isEmpty()) {
+                    QMutexLocker locker(&shard_locks[s]);
+                    shards[s] += local[s];
+                }
+            }
+        });
+    }
+    pool.waitForDone();
+
+    QAtomicInt groups;
+    for (int s = 0; s < shard_count; ++s) {
+        pool.start([this, s, &groups]() {
+            QVector<Item> &shard = shards[s];
+            std::sort(shard.begin(), shard.end());
+            int distinct = 0;
+            for (int i = 0; i < shard.size(); ++i) {
+                if (i == 0 || shard[i].hash != shard[i - 1].hash) {
+                    distinct++;
+                }
+            }
+            groups.fetchAndAddRelaxed(distinct);
+        });
+    }
+    pool.waitForDone();
+    unique_count = groups.loadRelaxed();
+}
+
+QString DuplicateStrings::language() const {
+    return section;
+}
+
+int DuplicateStrings::total() const {
+    return int(entry_hashes.size());
+}
+
+int DuplicateStrings::unique() const {
+    return unique_count;
+}
+
+double DuplicateStrings::unique_ratio() const {
+    return total() == 0 ? 1.0 : double(unique()) / double(total());
+}
+
+QVector<int> DuplicateStrings::duplicates_of(int index) const {
+    QVector<int> result;
+    if (index < 0 || index >= entry_hashes.size()) {
+        return result;
+    }
+    quint64 h = entry_hashes[index];
+    const QVector<Item> &shard = shards[shard_of(h)];
+    auto it = std::lower_bound(shard.constBegin(), shard.constEnd(), Item{h, 0});
+    for (; it != shard.constEnd() && it->hash == h; ++it) {
+        if (int(it->index) != index) {
+            result << int(it->index);
+        }
+    }
+    return result;
+}
+
+bool DuplicateStrings::same_text(int index, int other) const {
+    if (!indexed || index < 0 || other < 0 || index >= entry_hashes.size() || other >= entry_hashes.size()
+        || entry_hashes[index] != entry_hashes[other]) {
+        return false;
+    }
+    QByteArray texts[2];
+    indexed->for_each_in(section, index, index + 1, [&](int, QByteArrayView, QByteArrayView text) {
+        texts[0] = text.toByteArray();
+    });
+    indexed->for_each_in(section, other, other + 1, [&](int, QByteArrayView, QByteArrayView text) {
+        texts[1] = text.toByteArray();
+    });
+    return equal_normalised(texts[0], texts[1]);
+}
+
+QVector<QPair<int, int>> DuplicateStrings::largest_groups(int count) const {
+    QVector<QPair<int, int>> groups;
+    for (int s = 0; s < shard_count; ++s) {
+        const QVector<Item> &shard = shards[s];
+        for (int i = 0; i < shard.size();) {
+            int j = i + 1;
+            while (j < shard.size() && shard[j].hash == shard[i].hash) {
+                ++j;
+            }
+            if (j - i > 1) {
+                groups << qMakePair(int(shard[i].index), j - i);
+            }
+            i = j;
+        }
+    }
+
+    auto larger = [](const QPair<int, int> &a, const QPair<int, int> &b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    if (groups.size() > count) {
+        std::partial_sort(groups.begin(), groups.begin() + count, groups.end(), larger);
+        groups.resize(count);
+    } else {
+        std::sort(groups.begin(), groups.end(), larger);
+    }
+    return groups;
+}
+
+QSharedPointer<const LocaSnapshot> DuplicateStrings::snapshot() const {
+    return indexed;
+}
+
+QString DuplicateStrings::report(int groups) const {
+    QString text;
+    text += QString("%1 strings: %2 total, %3 unique (%4% of the translation work)\n")
+                .arg(section)
+                .arg(total())
+                .arg(unique())
+                .arg(unique_ratio() * 100.0, 0, 'f', 1);
+    for (const auto &group : largest_groups(groups)) {
+        QString sample;
+        if (indexed) {
+            indexed->entry(section, group.first, nullptr, &sample);
+        }
+        text += QString("%1x  %2\n").arg(group.second).arg(sample.left(80));
+    }
+    return text;
+}
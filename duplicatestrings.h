@@ -0,0 +1,64 @@
+#ifndef DUPLICATESTRINGS_H
+#define DUPLICATESTRINGS_H
+
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include <QSharedPointer>
+#include "locasnapshot.h"
+
+// Groups the entries of one snapshot language by a hash of their
+// whitespace-normalised text, so a translation made for one occurrence can be
+// reused for every identical line elsewhere. Hashing runs in parallel
+// straight over the mapped snapshot; the (hash, entry) pairs are split into
+// shards by the top hash bits and each shard is sorted on its own, which
+// makes a shard lookup a binary search and keeps the workers lock-free.
+class DuplicateStrings {
+public:
+    DuplicateStrings();
+    // Keeps the snapshot alive; entry indexes only mean something in it.
+    void build(const QSharedPointer<const LocaSnapshot> &snapshot, const QString &language, int threads = 0);
+    void clear();
+    QSharedPointer<const LocaSnapshot> snapshot() const;
+
+    QString language() const;
+    int total() const;
+    int unique() const;
+    // Fraction of strings that actually need translating once duplicates are shared.
+    double unique_ratio() const;
+
+    // Other entries whose normalised text hashes like entry index. Groups
+    // rest on the 64-bit hash alone; check same_text before reusing a
+    // translation.
+    QVector<int> duplicates_of(int index) const;
+    // Whether two entries really have the same normalised text.
+    bool same_text(int index, int other) const;
+    // Largest groups as (first entry, occurrences).
+    QVector<QPair<int, int>> largest_groups(int count) const;
+    QString report(int groups = 20) const;
+
+    static quint64 hash(const char *text, qsizetype length);
+
+private:
+    static const int shard_bits = 6;
+    static const int shard_count = 1 << shard_bits;
+
+    struct Item {
+        quint64 hash;
+        quint32 index;
+        bool operator<(const Item &other) const {
+            return hash != other.hash ? hash < other.hash : index < other.index;
+        }
+    };
+
+    static int shard_of(quint64 hash);
+    static bool equal_normalised(QByteArrayView a, QByteArrayView b);
+
+    QSharedPointer<const LocaSnapshot> indexed;
+    QString section;
+    QVector<quint64> entry_hashes;
+    QVector<Item> shards[shard_count];
+    int unique_count;
+};
+
+#endif
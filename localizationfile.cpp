@@ -0,0 +1,106 @@
+#include "localizationfile.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QXmlStreamReader>
+#include <QtEndian>
+#include <cstring>
+
+static const quint32 loca_signature = 0x41434f4c;  // "LOCA"
+static const int loca_header_size = 12;
+static const int loca_key_size = 64;
+static const int loca_entry_size = loca_key_size + 2 + 4;
+
+bool LocalizationFile::is_localization_file(const QString &path) {
+    QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "loca" || suffix == "xml";
+}
+
+bool LocalizationFile::read(const QString &path, QVector<Entry> &entries, QString &error, qint64 *bytes_read) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Unable to open " + path + ": " + file.errorString();
+        return false;
+    }
+
+    QByteArray data = file.readAll();
+    if (bytes_read) {
+        *bytes_read = data.size();
+    }
+    if (QFileInfo(path).suffix().compare("loca", Qt::CaseInsensitive) == 0) {
+        return read_loca(data, entries, error);
+    }
+    return read_xml(data, entries, error);
+}
+
+bool LocalizationFile::read_loca(const QByteArray &data, QVector<Entry> &entries, QString &error) {
+    if (data.size() < loca_header_size || qFromLittleEndian<quint32>(data.constData()) != loca_signature) {
+        error = "Not a .loca file";
+        return false;
+    }
+
+    quint32 count = qFromLittleEndian<quint32>(data.constData() + 4);
+    quint32 texts_offset = qFromLittleEndian<quint32>(data.constData() + 8);
+    if (loca_header_size + qint64(count) * loca_entry_size > data.size() || texts_offset > quint32(data.size())) {
+        error = "Corrupt .loca header";
+        return false;
+    }
+
+    entries.reserve(entries.size() + int(count));
+    qint64 text_pos = texts_offset;
+    for (quint32 i = 0; i < count; ++i) {
+        const char *p = data.constData() + loca_header_size + qint64(i) * loca_entry_size;
+        quint32 length = qFromLittleEndian<quint32>(p + loca_key_size + 2);
+        if (text_pos + length > data.size()) {
+            error = "Corrupt .loca text table";
+            return false;
+        }
+
+        Entry entry;
+        entry.key = QByteArray(p, qstrnlen(p, loca_key_size));
+        entry.version = qFromLittleEndian<quint16>(p + loca_key_size);
+        // Length includes the terminating NUL
+        entry.text = QString::fromUtf8(data.constData() + text_pos, length > 0 ? qint64(length) - 1 : 0);
+        entries << entry;
+        text_pos += length;
+    }
+    return true;
+}
+
+QByteArray LocalizationFile::write_loca(const QVector<Entry> &entries) {
+    QByteArray texts;
+    QByteArray output(loca_header_size + qint64(entries.size()) * loca_entry_size, '\0');
+    uchar *p = reinterpret_cast<uchar *>(output.data());
+    qToLittleEndian<quint32>(loca_signature, p);
+    qToLittleEndian<quint32>(quint32(entries.size()), p + 4);
+    qToLittleEndian<quint32>(quint32(output.size()), p + 8);
+
+    p += loca_header_size;
+    for (const Entry &entry : entries) {
+        QByteArray text = entry.text.toUtf8();
+        memcpy(p, entry.key.constData(), size_t(qMin<qsizetype>(entry.key.size(), loca_key_size - 1)));
+        qToLittleEndian<quint16>(entry.version, p + loca_key_size);
+        qToLittleEndian<quint32>(quint32(text.size() + 1), p + loca_key_size + 2);
+        texts += text;
+        texts += '\0';
+        p += loca_entry_size;
+    }
+    return output + texts;
+}
+
+bool LocalizationFile::read_xml(const QByteArray &data, QVector<Entry> &entries, QString &error) {
+    QXmlStreamReader xml(data);
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement && xml.name() == QLatin1String("content")) {
+            Entry entry;
+            entry.key = xml.attributes().value("contentuid").toLatin1();
+            entry.version = quint16(xml.attributes().value("version").toUInt());
+            entry.text = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+            entries << entry;
+        }
+    }
+    if (xml.hasError()) {
+        error = xml.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef LOCALIZATIONFILE_H
+#define LOCALIZATIONFILE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+// Reader for BG3 localization string tables, either binary .loca or the
+// <contentList> .xml form.
+class LocalizationFile {
+public:
+    struct Entry {
+        QByteArray key;  // contentuid
+        quint16 version;
+        QString text;
+    };
+
+    static bool read(const QString &path, QVector<Entry> &entries, QString &error, qint64 *bytes_read = nullptr);
+    static bool read_loca(const QByteArray &data, QVector<Entry> &entries, QString &error);
+    static bool read_xml(const QByteArray &data, QVector<Entry> &entries, QString &error);
+    static bool is_localization_file(const QString &path);
+    static QByteArray write_loca(const QVector<Entry> &entries);
+};
+
+#endif
@@ -0,0 +1,499 @@
+#include "locasnapshot.h"
+#include <QSaveFile>
+#include <QtEndian>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+
+int LocaSnapshot::compare_keys(QByteArrayView a, QByteArrayView b) {
+    int common = int(qMin(a.size(), b.size()));
+    int result = common == 0 ? 0 : std::memcmp(a.data(), b.data(), size_t(common));
+    if (result != 0) {
+        return result;
+    }
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+LocaSnapshot::LocaSnapshot() : data(nullptr), size(0), source_count(0), language_count(0),
+                               sources_offset(0), languages_offset(0), blob_offset(0), blob_size(0) {
+}
+
+LocaSnapshot::~LocaSnapshot() {
+    close();
+}
+
+bool LocaSnapshot::open(const QString &path) {
+    QWriteLocker locker(&lock);
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+    }
+    file.close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    size = file.size();
+    data = size >= header_size ? file.map(0, size) : nullptr;
+    if (!data) {
+        file.close();
+        return false;
+    }
+
+    const uchar *p = data;
+    source_count = qFromLittleEndian<quint32>(p + 8);
+    language_count = qFromLittleEndian<quint32>(p + 12);
+    sources_offset = qFromLittleEndian<quint32>(p + 16);
+    languages_offset = qFromLittleEndian<quint32>(p + 20);
+    blob_offset = qFromLittleEndian<quint32>(p + 24);
+    blob_size = qFromLittleEndian<quint32>(p + 28);
+    if (!validate()) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool LocaSnapshot::validate() const {
+    if (qFromLittleEndian<quint32>(data) != magic || qFromLittleEndian<quint32>(data + 4) != format_version) {
+        return false;
+    }
+    if (sources_offset + quint64(source_count) * source_record_size > quint64(size)
+        || languages_offset + quint64(language_count) * language_record_size > quint64(size)
+        || blob_offset + quint64(blob_size) > quint64(size)) {
+        return false;
+    }
+    // Entry ranges are checked here once so lookups only need to bound blob references
+    for (quint32 l = 0; l < language_count; ++l) {
+        const uchar *record = data + languages_offset + quint64(l) * language_record_size;
+        quint64 first = qFromLittleEndian<quint32>(record + 8);
+        quint64 count = qFromLittleEndian<quint32>(record + 12);
+        if (languages_offset + quint64(language_count) * language_record_size + (first + count) * entry_size > blob_offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LocaSnapshot::close() {
+    QWriteLocker locker(&lock);
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+    }
+    file.close();
+    if (discard.loadAcquire() && !file.fileName().isEmpty()) {
+        QFile::remove(file.fileName());
+        file.setFileName(QString());
+    }
+    size = 0;
+    source_count = 0;
+    language_count = 0;
+}
+
+void LocaSnapshot::discard_on_close() {
+    discard.storeRelease(1);
+}
+
+bool LocaSnapshot::is_open() const {
+    QReadLocker locker(&lock);
+    return data != nullptr;
+}
+
+QByteArrayView LocaSnapshot::blob(quint32 offset, quint32 length) const {
+    if (quint64(offset) + length > blob_size) {
+        return QByteArrayView();
+    }
+    return QByteArrayView(reinterpret_cast<const char *>(data + blob_offset + offset), length);
+}
+
+QByteArrayView LocaSnapshot::source_at(quint32 index) const {
+    if (index >= source_count) {
+        return QByteArrayView();
+    }
+    const uchar *record = data + sources_offset + quint64(index) * source_record_size;
+    return blob(qFromLittleEndian<quint32>(record), qFromLittleEndian<quint32>(record + 4));
+}
+
+QByteArrayView LocaSnapshot::language_at(quint32 index, quint32 *first, quint32 *count) const {
+    const uchar *record = data + languages_offset + quint64(index) * language_record_size;
+    *first = qFromLittleEndian<quint32>(record + 8);
+    *count = qFromLittleEndian<quint32>(record + 12);
+    return blob(qFromLittleEndian<quint32>(record), qFromLittleEndian<quint32>(record + 4));
+}
+
+int LocaSnapshot::language_index(const QString &language, quint32 *first, quint32 *count) const {
+    QByteArray name = language.toUtf8();
+    for (quint32 l = 0; data && l < language_count; ++l) {
+        if (compare_keys(language_at(l, first, count), name) == 0) {
+            return int(l);
+        }
+    }
+    return -1;
+}
+
+LocaSnapshot::EntryView LocaSnapshot::entry_at(quint32 index) const {
+    const uchar *record = data + languages_offset + quint64(language_count) * language_record_size + quint64(index) * entry_size;
+    EntryView entry;
+    entry.key = blob(qFromLittleEndian<quint32>(record), qFromLittleEndian<quint16>(record + 16));
+    entry.text = blob(qFromLittleEndian<quint32>(record + 4), qFromLittleEndian<quint32>(record + 8));
+    entry.source = qFromLittleEndian<quint32>(record + 12);
+    entry.version = qFromLittleEndian<quint16>(record + 18);
+    return entry;
+}
+
+quint32 LocaSnapshot::lower_bound(quint32 first, quint32 count, QByteArrayView key) const {
+    while (count > 0) {
+        quint32 step = count / 2;
+        if (compare_keys(entry_at(first + step).key, key) < 0) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+QStringList LocaSnapshot::languages() const {
+    QReadLocker locker(&lock);
+    QStringList names;
+    for (quint32 l = 0; data && l < language_count; ++l) {
+        quint32 first = 0;
+        quint32 count = 0;
+        names << QString::fromUtf8(language_at(l, &first, &count));
+    }
+    return names;
+}
+
+QByteArrayList LocaSnapshot::sources() const {
+    QReadLocker locker(&lock);
+    QByteArrayList names;
+    for (quint32 s = 0; data && s < source_count; ++s) {
+        names << source_at(s).toByteArray();
+    }
+    return names;
+}
+
+bool LocaSnapshot::has_source(const QByteArray &fingerprint) const {
+    QReadLocker locker(&lock);
+    if (!data) {
+        return false;
+    }
+    quint32 first = 0;
+    quint32 count = source_count;
+    while (count > 0) {
+        quint32 step = count / 2;
+        if (compare_keys(source_at(first + step), fingerprint) < 0) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first < source_count && compare_keys(source_at(first), fingerprint) == 0;
+}
+
+int LocaSnapshot::entry_count(const QString &language) const {
+    QReadLocker locker(&lock);
+    quint32 first = 0;
+    quint32 count = 0;
+    return language_index(language, &first, &count) < 0 ? 0 : int(count);
+}
+
+bool LocaSnapshot::lookup(const QString &language, const QByteArray &key, QString &text) const {
+    QReadLocker locker(&lock);
+    quint32 first = 0;
+    quint32 count = 0;
+    if (language_index(language, &first, &count) < 0) {
+        return false;
+    }
+    quint32 index = lower_bound(first, count, key);
+    if (index == first + count) {
+        return false;
+    }
+    EntryView entry = entry_at(index);
+    if (compare_keys(entry.key, key) != 0) {
+        return false;
+    }
+    text = QString::fromUtf8(entry.text);
+    return true;
+}
+
+int LocaSnapshot::index_of(const QString &language, const QByteArray &key) const {
+    QReadLocker locker(&lock);
+    quint32 first = 0;
+    quint32 count = 0;
+    if (language_index(language, &first, &count) < 0) {
+        return -1;
+    }
+    quint32 index = lower_bound(first, count, key);
+    if (index == first + count || compare_keys(entry_at(index).key, key) != 0) {
+        return -1;
+    }
+    return int(index - first);
+}
+
+bool LocaSnapshot::entry(const QString &language, int index, QByteArray *key, QString *text) const {
+    QReadLocker locker(&lock);
+    quint32 first = 0;
+    quint32 count = 0;
+    if (language_index(language, &first, &count) < 0 || index < 0 || quint32(index) >= count) {
+        return false;
+    }
+    EntryView view = entry_at(first + quint32(index));
+    if (key) {
+        *key = view.key.toByteArray();
+    }
+    if (text) {
+        *text = QString::fromUtf8(view.text);
+    }
+    return true;
+}
+
+QVector<LocalizationFile::Entry> LocaSnapshot::strings(const QString &language, const QSet<QByteArray> &sources) const {
+    QReadLocker locker(&lock);
+    QVector<LocalizationFile::Entry> result;
+    quint32 first = 0;
+    quint32 count = 0;
+    if (sources.isEmpty() || language_index(language, &first, &count) < 0) {
+        return result;
+    }
+
+    // Resolve fingerprints to source indexes once instead of per entry
+    QVector<bool> wanted(int(source_count), false);
+    for (quint32 s = 0; s < source_count; ++s) {
+        wanted[int(s)] = sources.contains(source_at(s).toByteArray());
+    }
+    for (quint32 i = first; i < first + count; ++i) {
+        EntryView entry = entry_at(i);
+        if (entry.source < source_count && wanted[int(entry.source)]) {
+            result << LocalizationFile::Entry{entry.key.toByteArray(), entry.version, QString::fromUtf8(entry.text)};
+        }
+    }
+    return result;
+}
+
+QHash<QByteArray, LocaSnapshot::Coverage> LocaSnapshot::coverage(const QString &source_language, const QString &target_language) const {
+    QReadLocker locker(&lock);
+    QHash<QByteArray, Coverage> result;
+    quint32 source_first = 0;
+    quint32 source_total = 0;
+    quint32 target_first = 0;
+    quint32 target_total = 0;
+    if (language_index(source_language, &source_first, &source_total) < 0) {
+        return result;
+    }
+    if (language_index(target_language, &target_first, &target_total) < 0) {
+        target_total = 0;
+    }
+
+    QVector<Coverage> per_source(int(source_count));
+    quint32 target = target_first;
+    quint32 target_end = target_first + target_total;
+    for (quint32 i = source_first; i < source_first + source_total; ++i) {
+        EntryView entry = entry_at(i);
+        while (target < target_end && compare_keys(entry_at(target).key, entry.key) < 0) {
+            ++target;
+        }
+        if (entry.source >= source_count) {
+            continue;
+        }
+        Coverage &coverage = per_source[int(entry.source)];
+        coverage.total++;
+        if (target < target_end && compare_keys(entry_at(target).key, entry.key) == 0) {
+            coverage.translated++;
+        }
+    }
+
+    for (quint32 s = 0; s < source_count; ++s) {
+        if (per_source[int(s)].total > 0) {
+            result.insert(source_at(s).toByteArray(), per_source[int(s)]);
+        }
+    }
+    return result;
+}
+
+LocaSnapshotBuilder::LocaSnapshotBuilder() {
+}
+
+void LocaSnapshotBuilder::clear() {
+    QMutexLocker locker(&mutex);
+    source_names.clear();
+    source_ids.clear();
+    fresh_sources.clear();
+    seen_sources.clear();
+    rows.clear();
+}
+
+quint32 LocaSnapshotBuilder::source_index_locked(const QByteArray &source) {
+    auto it = source_ids.constFind(source);
+    if (it != source_ids.constEnd()) {
+        return it.value();
+    }
+    quint32 index = quint32(source_names.size());
+    source_names << source;
+    source_ids.insert(source, index);
+    return index;
+}
+
+void LocaSnapshotBuilder::add(const QByteArray &source, const QString &language, const QVector<LocalizationFile::Entry> &entries) {
+    // Encode outside the lock, workers only contend on the append
+    QVector<Row> encoded;
+    encoded.reserve(entries.size());
+    for (const LocalizationFile::Entry &entry : entries) {
+        Row row;
+        row.key = entry.key;
+        row.text = entry.text.toUtf8();
+        row.version = entry.version;
+        row.source = 0;
+        encoded << row;
+    }
+
+    QMutexLocker locker(&mutex);
+    quint32 index = source_index_locked(source);
+    fresh_sources.insert(source);
+    seen_sources.insert(source);
+    QVector<Row> &language_rows = rows[language];
+    for (Row &row : encoded) {
+        row.source = index;
+        language_rows << row;
+    }
+}
+
+void LocaSnapshotBuilder::mark_seen(const QByteArray &source) {
+    QMutexLocker locker(&mutex);
+    seen_sources.insert(source);
+}
+
+bool LocaSnapshotBuilder::has_source(const QByteArray &source) {
+    QMutexLocker locker(&mutex);
+    return fresh_sources.contains(source);
+}
+
+void LocaSnapshotBuilder::carry_over(const LocaSnapshot &previous, bool prune, const QSet<QByteArray> &referenced) {
+    QMutexLocker locker(&mutex);
+    previous.for_each([&](const QByteArray &source, const QString &language, const QByteArray &key, quint16 version, const QByteArray &text) {
+        if (fresh_sources.contains(source) || (prune && !seen_sources.contains(source) && !referenced.contains(source))) {
+            return;
+        }
+        Row row;
+        row.key = key;
+        row.text = text;
+        row.version = version;
+        row.source = source_index_locked(source);
+        rows[language] << row;
+    });
+}
+
+bool LocaSnapshotBuilder::write(const QString &path, QString &error) {
+    QMutexLocker locker(&mutex);
+
+    // Sources are stored sorted so has_source can binary search them
+    QVector<quint32> order(source_names.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = quint32(i);
+    }
+    std::sort(order.begin(), order.end(), [this](quint32 a, quint32 b) {
+        return source_names[int(a)] < source_names[int(b)];
+    });
+    QVector<quint32> remap(source_names.size());
+    for (int i = 0; i < order.size(); ++i) {
+        remap[int(order[i])] = quint32(i);
+    }
+
+    QByteArray blob;
+    QHash<QByteArray, quint32> blob_offsets;
+    auto intern = [&](const QByteArray &bytes) -> quint32 {
+        auto it = blob_offsets.constFind(bytes);
+        if (it != blob_offsets.constEnd()) {
+            return it.value();
+        }
+        quint32 offset = quint32(blob.size());
+        blob += bytes;
+        blob_offsets.insert(bytes, offset);
+        return offset;
+    };
+
+    QByteArray sources_table(int(order.size()) * LocaSnapshot::source_record_size, '\0');
+    for (int i = 0; i < order.size(); ++i) {
+        const QByteArray &name = source_names[int(order[i])];
+        uchar *record = reinterpret_cast<uchar *>(sources_table.data()) + i * LocaSnapshot::source_record_size;
+        qToLittleEndian<quint32>(intern(name), record);
+        qToLittleEndian<quint32>(quint32(name.size()), record + 4);
+    }
+
+    QStringList language_names = rows.keys();
+    language_names.sort();
+    QByteArray languages_table(int(language_names.size()) * LocaSnapshot::language_record_size, '\0');
+    QByteArray entries_table;
+    quint32 entry_index = 0;
+    for (int l = 0; l < language_names.size(); ++l) {
+        QVector<Row> &language_rows = rows[language_names[l]];
+        for (Row &row : language_rows) {
+            row.source = remap[int(row.source)];
+        }
+        std::sort(language_rows.begin(), language_rows.end(), [](const Row &a, const Row &b) {
+            int order = LocaSnapshot::compare_keys(a.key, b.key);
+            return order != 0 ? order < 0 : a.source < b.source;
+        });
+
+        QByteArray name = language_names[l].toUtf8();
+        uchar *record = reinterpret_cast<uchar *>(languages_table.data()) + l * LocaSnapshot::language_record_size;
+        qToLittleEndian<quint32>(intern(name), record);
+        qToLittleEndian<quint32>(quint32(name.size()), record + 4);
+        qToLittleEndian<quint32>(entry_index, record + 8);
+        qToLittleEndian<quint32>(quint32(language_rows.size()), record + 12);
+
+        QByteArray entries(int(language_rows.size()) * LocaSnapshot::entry_size, '\0');
+        uchar *entry = reinterpret_cast<uchar *>(entries.data());
+        for (const Row &row : language_rows) {
+            qToLittleEndian<quint32>(intern(row.key), entry);
+            qToLittleEndian<quint32>(intern(row.text), entry + 4);
+            qToLittleEndian<quint32>(quint32(row.text.size()), entry + 8);
+            qToLittleEndian<quint32>(row.source, entry + 12);
+            qToLittleEndian<quint16>(quint16(qMin<qsizetype>(row.key.size(), 0xffff)), entry + 16);
+            qToLittleEndian<quint16>(row.version, entry + 18);
+            entry += LocaSnapshot::entry_size;
+        }
+        entries_table += entries;
+        entry_index += quint32(language_rows.size());
+    }
+
+    quint64 sources_offset = LocaSnapshot::header_size;
+    quint64 languages_offset = sources_offset + sources_table.size();
+    quint64 blob_offset = languages_offset + languages_table.size() + entries_table.size();
+    if (blob_offset + blob.size() > 0xffffffffULL) {
+        error = "Localization snapshot exceeds 4 GB";
+        return false;
+    }
+
+    uchar header[LocaSnapshot::header_size];
+    qToLittleEndian<quint32>(LocaSnapshot::magic, header);
+    qToLittleEndian<quint32>(LocaSnapshot::format_version, header + 4);
+    qToLittleEndian<quint32>(quint32(order.size()), header + 8);
+    qToLittleEndian<quint32>(quint32(language_names.size()), header + 12);
+    qToLittleEndian<quint32>(quint32(sources_offset), header + 16);
+    qToLittleEndian<quint32>(quint32(languages_offset), header + 20);
+    qToLittleEndian<quint32>(quint32(blob_offset), header + 24);
+    qToLittleEndian<quint32>(quint32(blob.size()), header + 28);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(header), LocaSnapshot::header_size);
+    file.write(sources_table);
+    file.write(languages_table);
+    file.write(entries_table);
+    file.write(blob);
+    if (!file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,254 @@
+#ifndef LOCASNAPSHOT_H
+#define LOCASNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QByteArrayView>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QFile>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+#include "localizationfile.h"
+
+// Read-only view of every scanned localization string, loaded with a single
+// map of the snapshot file. Strings are grouped into one section per
+// language, sorted by contentuid, and tagged with the fingerprint of the pak
+// ("source") they came from. Nothing is copied onto the heap until asked for.
+//
+// Layout (little endian):
+//   header    magic "DMTL", version, source count, language count,
+//             sources offset, languages offset, blob offset, blob size
+//   sources   sorted fingerprints, {blob offset, length} each
+//   languages {name offset, name length, first entry, entry count} each
+//   entries   {key offset, text offset, text length, source, key length, version}
+//   blob      deduplicated UTF-8 for names, keys and texts
+class LocaSnapshot {
+public:
+    struct Coverage {
+        int total = 0;
+        int translated = 0;
+    };
+
+    LocaSnapshot();
+    ~LocaSnapshot();
+    LocaSnapshot(const LocaSnapshot &) = delete;
+    LocaSnapshot &operator=(const LocaSnapshot &) = delete;
+
+    bool open(const QString &path);
+    void close();
+    bool is_open() const;
+    // The file is deleted once the snapshot is closed, for a superseded
+    // snapshot that readers may still hold.
+    void discard_on_close();
+
+    QStringList languages() const;
+    QByteArrayList sources() const;
+    bool has_source(const QByteArray &fingerprint) const;
+    int entry_count(const QString &language) const;
+    bool lookup(const QString &language, const QByteArray &key, QString &text) const;
+    // Entries of one language are addressed by their position in its section.
+    int index_of(const QString &language, const QByteArray &key) const;
+    bool entry(const QString &language, int index, QByteArray *key, QString *text) const;
+    // Calls visit(index, key, text) for entries [begin, end) of one language,
+    // handing out views straight into the mapped file.
+    template <typename Visitor>
+    void for_each_in(const QString &language, int begin, int end, Visitor visit) const;
+
+    // Calls visit(source index, key) for every entry of language in key order;
+    // source indexes refer to sources().
+    template <typename Visitor>
+    void for_each_key(const QString &language, Visitor visit) const;
+
+    // Number of entries in language per source for which matches(key, text) holds.
+    template <typename Predicate>
+    QHash<QByteArray, int> count_by_source(const QString &language, Predicate matches) const;
+
+    // Every entry in language that came from one of sources, in key order.
+    QVector<LocalizationFile::Entry> strings(const QString &language, const QSet<QByteArray> &sources) const;
+
+    // Per source: how many of its source_language keys also exist in
+    // target_language, from any source. One merge pass over both sections.
+    QHash<QByteArray, Coverage> coverage(const QString &source_language, const QString &target_language) const;
+
+    // Calls visit(source, language, key, version, text) for every entry.
+    template <typename Visitor>
+    void for_each(Visitor visit) const;
+    // Calls visit(key, source_text, target_text) for every contentuid present
+    // in both languages, walking the two sorted sections side by side.
+    template <typename Visitor>
+    void for_each_pair(const QString &source_language, const QString &target_language, Visitor visit) const;
+
+    // Byte-wise key order used for every sorted section.
+    static int compare_keys(QByteArrayView a, QByteArrayView b);
+
+    static const quint32 magic = 0x4c544d44;  // "DMTL"
+    static const quint32 format_version = 1;
+    static const int header_size = 32;
+    static const int source_record_size = 8;
+    static const int language_record_size = 16;
+    static const int entry_size = 20;
+
+private:
+    struct EntryView {
+        QByteArrayView key;
+        QByteArrayView text;
+        quint32 source;
+        quint16 version;
+    };
+
+    bool validate() const;
+    QByteArrayView blob(quint32 offset, quint32 length) const;
+    QByteArrayView source_at(quint32 index) const;
+    QByteArrayView language_at(quint32 index, quint32 *first, quint32 *count) const;
+    int language_index(const QString &language, quint32 *first, quint32 *count) const;
+    EntryView entry_at(quint32 index) const;
+    quint32 lower_bound(quint32 first, quint32 count, QByteArrayView key) const;
+
+    mutable QReadWriteLock lock;
+    QFile file;
+    QAtomicInt discard;
+    const uchar *data;
+    qint64 size;
+    quint32 source_count;
+    quint32 language_count;
+    quint32 sources_offset;
+    quint32 languages_offset;
+    quint32 blob_offset;
+    quint32 blob_size;
+};
+
+template <typename Visitor>
+void LocaSnapshot::for_each(Visitor visit) const {
+    QReadLocker locker(&lock);
+    for (quint32 l = 0; data && l < language_count; ++l) {
+        quint32 first = 0;
+        quint32 count = 0;
+        QString language = QString::fromUtf8(language_at(l, &first, &count));
+        for (quint32 i = first; i < first + count; ++i) {
+            EntryView entry = entry_at(i);
+            visit(source_at(entry.source).toByteArray(), language, entry.key.toByteArray(), entry.version, entry.text.toByteArray());
+        }
+    }
+}
+
+template <typename Visitor>
+void LocaSnapshot::for_each_pair(const QString &source_language, const QString &target_language, Visitor visit) const {
+    QReadLocker locker(&lock);
+    quint32 source_first = 0;
+    quint32 source_count = 0;
+    quint32 target_first = 0;
+    quint32 target_count = 0;
+    if (language_index(source_language, &source_first, &source_count) < 0
+        || language_index(target_language, &target_first, &target_count) < 0) {
+        return;
+    }
+
+    quint32 target = target_first;
+    quint32 target_end = target_first + target_count;
+    for (quint32 i = source_first; i < source_first + source_count && target < target_end; ++i) {
+        EntryView entry = entry_at(i);
+        int order = -1;
+        while (target < target_end && (order = compare_keys(entry_at(target).key, entry.key)) < 0) {
+            ++target;
+        }
+        if (target < target_end && order == 0) {
+            visit(entry.key, entry.text, entry_at(target).text);
+        }
+    }
+}
+
+template <typename Visitor>
+void LocaSnapshot::for_each_in(const QString &language, int begin, int end, Visitor visit) const {
+    QReadLocker locker(&lock);
+    quint32 first = 0;
+    quint32 count = 0;
+    if (language_index(language, &first, &count) < 0) {
+        return;
+    }
+    for (int i = qMax(0, begin); i < qMin(end, int(count)); ++i) {
+        EntryView entry = entry_at(first + quint32(i));
+        visit(i, entry.key, entry.text);
+    }
+}
+
+template <typename Visitor>
+void LocaSnapshot::for_each_key(const QString &language, Visitor visit) const {
+    QReadLocker locker(&lock);
+    quint32 first = 0;
+    quint32 count = 0;
+    if (language_index(language, &first, &count) < 0) {
+        return;
+    }
+    for (quint32 i = first; i < first + count; ++i) {
+        EntryView entry = entry_at(i);
+        visit(entry.source, entry.key);
+    }
+}
+
+template <typename Predicate>
+QHash<QByteArray, int> LocaSnapshot::count_by_source(const QString &language, Predicate matches) const {
+    QReadLocker locker(&lock);
+    QHash<QByteArray, int> counts;
+    quint32 first = 0;
+    quint32 count = 0;
+    if (language_index(language, &first, &count) < 0) {
+        return counts;
+    }
+    QVector<int> per_source(int(source_count), 0);
+    for (quint32 i = first; i < first + count; ++i) {
+        EntryView entry = entry_at(i);
+        if (entry.source < source_count && matches(entry.key, entry.text)) {
+            per_source[int(entry.source)]++;
+        }
+    }
+    for (quint32 s = 0; s < source_count; ++s) {
+        if (per_source[int(s)] > 0) {
+            counts.insert(source_at(s).toByteArray(), per_source[int(s)]);
+        }
+    }
+    return counts;
+}
+
+// Collects strings from scan workers and writes them out as a snapshot.
+class LocaSnapshotBuilder {
+public:
+    LocaSnapshotBuilder();
+    void clear();
+
+    // Thread-safe, called once per pak and language.
+    void add(const QByteArray &source, const QString &language, const QVector<LocalizationFile::Entry> &entries);
+    // Remember a source was part of this scan even if nothing was parsed for it.
+    void mark_seen(const QByteArray &source);
+    bool has_source(const QByteArray &source);
+
+    // Copies entries from the previous snapshot for sources not rebuilt in this
+    // scan. With prune set, sources neither seen during the scan nor in
+    // referenced are dropped.
+    void carry_over(const LocaSnapshot &previous, bool prune, const QSet<QByteArray> &referenced);
+
+    bool write(const QString &path, QString &error);
+
+private:
+    struct Row {
+        QByteArray key;
+        QByteArray text;
+        quint32 source;
+        quint16 version;
+    };
+
+    quint32 source_index_locked(const QByteArray &source);
+
+    QMutex mutex;
+    QVector<QByteArray> source_names;
+    QHash<QByteArray, quint32> source_ids;
+    QSet<QByteArray> fresh_sources;
+    QSet<QByteArray> seen_sources;
+    QHash<QString, QVector<Row>> rows;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "lspkreader.h"
+#include "lz4block.h"
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QtEndian>
+#include <zlib.h>
+
+static const int header_size = 40;
+static const int entry15_size = 296;
+static const int entry18_size = 272;
+static const int name_size = 256;
+
+LspkReader::LspkReader(const QString &path) : file(path), mapped_bytes(0), package_version(0), num_parts(1),
+                                              table_offset(0), table_size(0), read_bytes(0) {
+}
+
+LspkReader::~LspkReader() {
+    for (Part &part : parts) {
+        if (part.data) {
+            part.file->unmap(const_cast<uchar *>(part.data));
+        }
+    }
+}
+
+QString LspkReader::error_string() const {
+    return error;
+}
+
+quint32 LspkReader::version() const {
+    return package_version;
+}
+
+int LspkReader::part_count() const {
+    return num_parts;
+}
+
+const QVector<LspkReader::Entry> &LspkReader::entries() const {
+    return entry_list;
+}
+
+qint64 LspkReader::bytes_read() const {
+    return read_bytes;
+}
+
+qint64 LspkReader::bytes_mapped() const {
+    return mapped_bytes;
+}
+
+QString LspkReader::part_path(int part) const {
+    if (part == 0) {
+        return file.fileName();
+    }
+    QFileInfo info(file.fileName());
+    return info.path() + "/" + info.completeBaseName() + "_" + QString::number(part) + "." + info.suffix();
+}
+
+QString LspkReader::main_part_for(const QString &path, int *part) {
+    static const QRegularExpression part_pattern("^(.*)_(\\d+)\\.pak$", QRegularExpression::CaseInsensitiveOption);
+    QFileInfo info(path);
+    QRegularExpressionMatch match = part_pattern.match(info.fileName());
+    if (!match.hasMatch()) {
+        return QString();
+    }
+
+    QString main_path = info.path() + "/" + match.captured(1) + ".pak";
+    if (!QFileInfo::exists(main_path)) {
+        return QString();
+    }
+    if (part) {
+        *part = match.captured(2).toInt();
+    }
+    return main_path;
+}
+
+int LspkReader::read_part_count(const QString &path, qint64 *bytes_read) {
+    LspkReader reader(path);
+    bool opened = reader.read_header();
+    if (bytes_read) {
+        *bytes_read += reader.bytes_read();
+    }
+    return opened ? reader.part_count() : 0;
+}
+
+bool LspkReader::is_secondary_part(const QString &path, QHash<QString, int> *part_counts, qint64 *bytes_read) {
+    int part = 0;
+    QString main_path = main_part_for(path, &part);
+    if (main_path.isEmpty()) {
+        return false;
+    }
+
+    int count = part_counts ? part_counts->value(main_path, -1) : -1;
+    if (count < 0) {
+        count = read_part_count(main_path, bytes_read);
+        if (part_counts) {
+            part_counts->insert(main_path, count);
+        }
+    }
+    return part > 0 && part < count;
+}
+
+const LspkReader::Part *LspkReader::map_part(int index) {
+    if (index < 0 || index >= int(parts.size())) {
+        error = QString("%1: entry refers to missing part %2").arg(file.fileName()).arg(index);
+        return nullptr;
+    }
+
+    Part &part = parts[size_t(index)];
+    if (!part.data) {
+        part.file.reset(new QFile(part_path(index)));
+        if (!part.file->open(QIODevice::ReadOnly)) {
+            error = "Unable to open " + part.file->fileName() + ": " + part.file->errorString();
+            return nullptr;
+        }
+        part.size = part.file->size();
+        part.data = part.file->map(0, part.size);
+        if (!part.data) {
+            error = "Unable to map " + part.file->fileName();
+            return nullptr;
+        }
+        mapped_bytes += part.size;
+    }
+    return &part;
+}
+
+QByteArray LspkReader::read_entry(const Entry &entry) {
+    const Part *part = map_part(entry.archive_part);
+    if (!part) {
+        return QByteArray();
+    }
+    if (entry.offset + entry.size_on_disk > quint64(part->size)) {
+        error = entry.name + ": data out of range";
+        return QByteArray();
+    }
+
+    const char *data = reinterpret_cast<const char *>(part->data + entry.offset);
+    switch (entry.compression()) {
+        case CompressionNone:
+            return QByteArray(data, qint64(entry.size_on_disk));
+        case CompressionLz4: {
+            QByteArray output(qint64(entry.uncompressed_size), Qt::Uninitialized);
+            if (Lz4Block::decompress(data, qint64(entry.size_on_disk), output.data(), output.size()) != output.size()) {
+                error = entry.name + ": corrupt LZ4 data";
+                return QByteArray();
+            }
+            return output;
+        }
+        case CompressionZlib: {
+            QByteArray output(qint64(entry.uncompressed_size), Qt::Uninitialized);
+            uLongf output_size = uLongf(output.size());
+            if (uncompress(reinterpret_cast<Bytef *>(output.data()), &output_size,
+                           reinterpret_cast<const Bytef *>(data), uLong(entry.size_on_disk)) != Z_OK
+                || output_size != uLongf(output.size())) {
+                error = entry.name + ": corrupt zlib data";
+                return QByteArray();
+            }
+            return output;
+        }
+        default:
+            error = QString("%1: unsupported compression method %2").arg(entry.name).arg(entry.compression());
+            return QByteArray();
+    }
+}
+
+QByteArray LspkReader::read_raw(const Entry &entry) {
+    const Part *part = map_part(entry.archive_part);
+    if (!part) {
+        return QByteArray();
+    }
+    if (entry.offset + entry.size_on_disk > quint64(part->size)) {
+        error = entry.name + ": data out of range";
+        return QByteArray();
+    }
+    return QByteArray(reinterpret_cast<const char *>(part->data + entry.offset), qint64(entry.size_on_disk));
+}
+
+bool LspkReader::open() {
+    return read_header() && read_file_table(table_offset, table_size);
+}
+
+bool LspkReader::read_header() {
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Unable to open " + file.fileName() + ": " + file.errorString();
+        return false;
+    }
+
+    QByteArray header = file.read(header_size);
+    read_bytes += header.size();
+    if (header.size() < header_size || !header.startsWith("LSPK")) {
+        error = file.fileName() + " is not an LSPK v15+ package";
+        return false;
+    }
+
+    const char *data = header.constData();
+    package_version = qFromLittleEndian<quint32>(data + 4);
+    table_offset = qFromLittleEndian<quint64>(data + 8);
+    table_size = qFromLittleEndian<quint32>(data + 16);
+    if (package_version != 15 && package_version != 16 && package_version != 18) {
+        error = QString("%1: unsupported package version %2").arg(file.fileName()).arg(package_version);
+        return false;
+    }
+    if (package_version >= 16) {
+        num_parts = qMax(1, int(qFromLittleEndian<quint16>(data + 38)));
+    }
+    parts.resize(num_parts);
+    return true;
+}
+
+bool LspkReader::read_file_table(quint64 offset, quint32 size) {
+    if (offset + size > quint64(file.size()) || size < 8 || !file.seek(qint64(offset))) {
+        error = file.fileName() + ": file table out of range";
+        return false;
+    }
+
+    QByteArray table = file.read(size);
+    read_bytes += table.size();
+    if (table.size() != qint64(size)) {
+        error = file.fileName() + ": truncated file table";
+        return false;
+    }
+
+    quint32 num_files = qFromLittleEndian<quint32>(table.constData());
+    quint32 compressed_size = qFromLittleEndian<quint32>(table.constData() + 4);
+    int entry_size = package_version == 18 ? entry18_size : entry15_size;
+    if (compressed_size > quint32(table.size() - 8) || quint64(num_files) * entry_size > 512ULL * 1024 * 1024) {
+        error = file.fileName() + ": corrupt file table";
+        return false;
+    }
+
+    QByteArray raw(qint64(num_files) * entry_size, Qt::Uninitialized);
+    qint64 decoded = Lz4Block::decompress(table.constData() + 8, compressed_size, raw.data(), raw.size());
+    if (decoded != raw.size()) {
+        error = file.fileName() + ": unable to decompress file table";
+        return false;
+    }
+
+    entry_list.clear();
+    entry_list.reserve(int(num_files));
+    for (quint32 i = 0; i < num_files; ++i) {
+        const char *p = raw.constData() + qint64(i) * entry_size;
+        Entry entry;
+        entry.name = QString::fromUtf8(p, qstrnlen(p, name_size));
+        if (package_version == 18) {
+            entry.offset = qFromLittleEndian<quint32>(p + 256) | (quint64(qFromLittleEndian<quint16>(p + 260)) << 32);
+            entry.archive_part = quint8(p[262]);
+            entry.flags = quint8(p[263]);
+            entry.size_on_disk = qFromLittleEndian<quint32>(p + 264);
+            entry.uncompressed_size = qFromLittleEndian<quint32>(p + 268);
+        } else {
+            entry.offset = qFromLittleEndian<quint64>(p + 256);
+            entry.size_on_disk = qFromLittleEndian<quint64>(p + 264);
+            entry.uncompressed_size = qFromLittleEndian<quint64>(p + 272);
+            entry.archive_part = int(qFromLittleEndian<quint32>(p + 280));
+            entry.flags = qFromLittleEndian<quint32>(p + 284);
+        }
+        entry_list << entry;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef LSPKREADER_H
+#define LSPKREADER_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QByteArray>
+#include <QHash>
+#include <memory>
+#include <vector>
+
+// Reads a Larian LSPK package (v15, v16, v18). Split packages (Foo.pak,
+// Foo_1.pak, ...) are one logical archive: the table is only stored in the
+// main file and each entry names the part holding its data. Parts are memory
+// mapped on first access, so an archive whose wanted entries all live in the
+// main file never opens the others.
+class LspkReader {
+public:
+    enum CompressionMethod {
+        CompressionNone = 0,
+        CompressionZlib = 1,
+        CompressionLz4 = 2,
+        CompressionZstd = 3
+    };
+
+    struct Entry {
+        QString name;
+        quint64 offset;
+        quint64 size_on_disk;
+        quint64 uncompressed_size;
+        int archive_part;
+        quint32 flags;
+
+        int compression() const { return flags & 0x0F; }
+    };
+
+    explicit LspkReader(const QString &path);
+    ~LspkReader();
+    LspkReader(const LspkReader &) = delete;
+    LspkReader &operator=(const LspkReader &) = delete;
+
+    bool open();
+    QString error_string() const;
+    quint32 version() const;
+    int part_count() const;
+    const QVector<Entry> &entries() const;
+    qint64 bytes_read() const;
+    qint64 bytes_mapped() const;
+
+    QString part_path(int part) const;
+    // Decompressed contents of an entry, or a null array with error_string() set.
+    QByteArray read_entry(const Entry &entry);
+    // The entry's bytes as stored, still compressed.
+    QByteArray read_raw(const Entry &entry);
+
+    // For foo_N.pak, the main package path if one exists next to it.
+    static QString main_part_for(const QString &path, int *part = nullptr);
+    // Part count from the package header alone, without the file table; 0 if
+    // path is not a readable package.
+    static int read_part_count(const QString &path, qint64 *bytes_read = nullptr);
+    // True only if the main package really has that many parts; Foo_1.pak can
+    // just as well be a package of its own whose name ends in a number. Part
+    // counts are looked up in, and added to, part_counts when given.
+    static bool is_secondary_part(const QString &path, QHash<QString, int> *part_counts = nullptr, qint64 *bytes_read = nullptr);
+
+private:
+    struct Part {
+        std::unique_ptr<QFile> file;
+        const uchar *data = nullptr;
+        qint64 size = 0;
+    };
+
+    bool read_header();
+    bool read_file_table(quint64 offset, quint32 size);
+    const Part *map_part(int part);
+
+    QFile file;
+    std::vector<Part> parts;
+    qint64 mapped_bytes;
+    QString error;
+    quint32 package_version;
+    int num_parts;
+    quint64 table_offset;
+    quint32 table_size;
+    QVector<Entry> entry_list;
+    qint64 read_bytes;
+};
+
+#endif
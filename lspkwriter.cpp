@@ -0,0 +1,161 @@
+#include "lspkwriter.h"
+#include "lz4block.h"
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QtEndian>
+#include <zlib.h>
+#include <cstring>
+
+static const quint32 package_version = 18;
+static const int header_size = 40;
+static const int entry_size = 272;
+static const int name_size = 256;
+static const int data_alignment = 64;
+// Compression level bits LSLib stores next to the method
+static const quint8 default_level = 0x20;
+
+LspkWriter::LspkWriter(const QString &path) : file_path(path), compression_method(LspkReader::CompressionLz4) {
+}
+
+void LspkWriter::set_compression(int method) {
+    compression_method = method;
+}
+
+QString LspkWriter::error_string() const {
+    return error;
+}
+
+const QVector<LspkWriter::File> &LspkWriter::files() const {
+    return written;
+}
+
+void LspkWriter::add_file(const QString &name, const QByteArray &data) {
+    Pending entry;
+    entry.file.name = name;
+    entry.file.data = data;
+    entry.file.compression = compression_method;
+    entry.uncompressed_size = data.size();
+    pending << entry;
+}
+
+void LspkWriter::add_compressed_file(const QString &name, const QByteArray &compressed, int method, qint64 uncompressed_size) {
+    Pending entry;
+    entry.file.name = name;
+    entry.file.compressed = compressed;
+    entry.file.compression = method;
+    entry.uncompressed_size = uncompressed_size;
+    pending << entry;
+}
+
+QByteArray LspkWriter::compress(const QByteArray &data, int method) {
+    switch (method) {
+        case LspkReader::CompressionLz4:
+            return Lz4Block::compress(data);
+        case LspkReader::CompressionZlib: {
+            QByteArray output(qint64(compressBound(uLong(data.size()))), Qt::Uninitialized);
+            uLongf output_size = uLongf(output.size());
+            if (compress2(reinterpret_cast<Bytef *>(output.data()), &output_size,
+                          reinterpret_cast<const Bytef *>(data.constData()), uLong(data.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+                return QByteArray();
+            }
+            output.truncate(qint64(output_size));
+            return output;
+        }
+        default:
+            return data;
+    }
+}
+
+bool LspkWriter::write(int max_threads) {
+    written.clear();
+    for (const Pending &entry : pending) {
+        if (entry.file.name.toUtf8().size() >= name_size) {
+            error = entry.file.name + ": name too long for an LSPK entry";
+            return false;
+        }
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(max_threads > 0 ? max_threads : QThread::idealThreadCount());
+    for (Pending &entry : pending) {
+        if (entry.file.compressed.isNull() && entry.file.compression != LspkReader::CompressionNone) {
+            pool.start([&entry]() {
+                entry.file.compressed = compress(entry.file.data, entry.file.compression);
+            });
+        }
+    }
+    pool.waitForDone();
+
+    // Offsets are fixed now, so the file table can be built before writing
+    QByteArray table(qint64(pending.size()) * entry_size, '\0');
+    quint64 offset = header_size;
+    for (int i = 0; i < pending.size(); ++i) {
+        Pending &entry = pending[i];
+        if (entry.file.compression == LspkReader::CompressionNone) {
+            entry.file.compressed = entry.file.data;
+        } else if (entry.file.compressed.isNull()) {
+            error = entry.file.name + ": compression failed";
+            return false;
+        }
+
+        uchar *record = reinterpret_cast<uchar *>(table.data()) + qint64(i) * entry_size;
+        QByteArray name = entry.file.name.toUtf8();
+        memcpy(record, name.constData(), size_t(name.size()));
+        qToLittleEndian<quint32>(quint32(offset), record + 256);
+        qToLittleEndian<quint16>(quint16(offset >> 32), record + 260);
+        record[262] = 0;
+        record[263] = quint8(entry.file.compression) | (entry.file.compression == LspkReader::CompressionNone ? 0 : default_level);
+        qToLittleEndian<quint32>(quint32(entry.file.compressed.size()), record + 264);
+        qToLittleEndian<quint32>(entry.file.compression == LspkReader::CompressionNone ? 0 : quint32(entry.uncompressed_size), record + 268);
+
+        offset += quint64(entry.file.compressed.size());
+        offset = (offset + data_alignment - 1) / data_alignment * data_alignment;
+    }
+    if (offset >> 48) {
+        error = "Package too large for LSPK v18";
+        return false;
+    }
+
+    QByteArray compressed_table = Lz4Block::compress(table);
+    quint64 table_offset = offset;
+
+    uchar header[header_size] = {};
+    memcpy(header, "LSPK", 4);
+    qToLittleEndian<quint32>(package_version, header + 4);
+    qToLittleEndian<quint64>(table_offset, header + 8);
+    qToLittleEndian<quint32>(quint32(compressed_table.size() + 8), header + 16);
+    // flags, priority and the MD5 field stay zero, as for unsigned mod packages
+    qToLittleEndian<quint16>(1, header + 38);
+
+    QSaveFile file(file_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = "Unable to write " + file_path + ": " + file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(header), header_size);
+    qint64 position = header_size;
+    for (const Pending &entry : pending) {
+        file.write(entry.file.compressed);
+        position += entry.file.compressed.size();
+        qint64 padding = (data_alignment - position % data_alignment) % data_alignment;
+        file.write(QByteArray(padding, '\0'));
+        position += padding;
+    }
+
+    uchar table_header[8];
+    qToLittleEndian<quint32>(quint32(pending.size()), table_header);
+    qToLittleEndian<quint32>(quint32(compressed_table.size()), table_header + 4);
+    file.write(reinterpret_cast<const char *>(table_header), 8);
+    file.write(compressed_table);
+    if (!file.commit()) {
+        error = "Unable to write " + file_path + ": " + file.errorString();
+        return false;
+    }
+
+    for (const Pending &entry : pending) {
+        written << entry.file;
+    }
+    pending.clear();
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef LSPKWRITER_H
+#define LSPKWRITER_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include "lspkreader.h"
+
+// Writes a single-part LSPK v18 package. Entries are compressed in parallel
+// first; since every compressed size is then known, the header, entry data
+// and file table go out in one sequential pass.
+class LspkWriter {
+public:
+    struct File {
+        QString name;
+        QByteArray data;
+        // Already compressed data can be passed straight through.
+        QByteArray compressed;
+        int compression = LspkReader::CompressionNone;
+    };
+
+    explicit LspkWriter(const QString &path);
+    void set_compression(int method);
+    void add_file(const QString &name, const QByteArray &data);
+    void add_compressed_file(const QString &name, const QByteArray &compressed, int method, qint64 uncompressed_size);
+    bool write(int max_threads = 0);
+    QString error_string() const;
+    const QVector<File> &files() const;
+
+    static QByteArray compress(const QByteArray &data, int method);
+
+private:
+    struct Pending {
+        File file;
+        qint64 uncompressed_size;
+    };
+
+    QString file_path;
+    int compression_method;
+    QVector<Pending> pending;
+    QVector<File> written;
+    QString error;
+};
+
+#endif
@@ -0,0 +1,699 @@
+#include "lsresource.h"
+#include "lz4block.h"
+#include <QFile>
+#include <QtEndian>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+static const quint32 lsf_signature = 0x464F534C;  // "LSOF"
+// Node and attribute records with sibling links (LSF v3+ with adjacency data)
+static const quint32 lsf_extended_format = 1;
+static const int compression_zlib = 1;
+static const int compression_lz4 = 2;
+
+namespace {
+
+// .lsx type names, indexed by type id
+const char *const type_names[LsResource::TypeCount] = {
+    "None", "uint8", "int16", "uint16", "int32", "uint32", "float", "double",
+    "ivec2", "ivec3", "ivec4", "fvec2", "fvec3", "fvec4",
+    "mat2x2", "mat3x3", "mat3x4", "mat4x3", "mat4x4", "bool",
+    "string", "path", "FixedString", "LSString", "uint64", "ScratchBuffer", "old_int64", "int8",
+    "TranslatedString", "WString", "LSWString", "guid", "int64", "TranslatedFSString"
+};
+
+bool same(QByteArrayView a, QByteArrayView b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), size_t(a.size())) == 0;
+}
+
+int type_from_name(QByteArrayView name) {
+    for (int type = 0; type < LsResource::TypeCount; ++type) {
+        if (same(name, QByteArrayView(type_names[type], qsizetype(strlen(type_names[type]))))) {
+            return type;
+        }
+    }
+    // Older .lsx files write the numeric id
+    bool ok = false;
+    int type = name.toByteArray().toInt(&ok);
+    return ok && type >= 0 && type < LsResource::TypeCount ? type : LsResource::TypeNone;
+}
+
+int vector_components(int type) {
+    switch (type) {
+        case LsResource::TypeIVec2: case LsResource::TypeVec2: return 2;
+        case LsResource::TypeIVec3: case LsResource::TypeVec3: return 3;
+        case LsResource::TypeIVec4: case LsResource::TypeVec4: case LsResource::TypeMat2: return 4;
+        case LsResource::TypeMat3: return 9;
+        case LsResource::TypeMat3x4: case LsResource::TypeMat4x3: return 12;
+        case LsResource::TypeMat4: return 16;
+        default: return 0;
+    }
+}
+
+// Upper bound for the text form of a binary value of the given size.
+qsizetype text_bound(quint32 length) {
+    return qsizetype(length) * 4 + 64;
+}
+
+qsizetype copy_string(const uchar *data, quint32 length, char *out) {
+    while (length > 0 && data[length - 1] == 0) {
+        --length;
+    }
+    memcpy(out, data, length);
+    return length;
+}
+
+// Writes an LSF value the way .lsx spells it and returns its length.
+qsizetype format_value(int type, const uchar *data, quint32 length, quint32 version, char *out) {
+    switch (type) {
+        case LsResource::TypeString:
+        case LsResource::TypePath:
+        case LsResource::TypeFixedString:
+        case LsResource::TypeLSString:
+        case LsResource::TypeWString:
+        case LsResource::TypeLSWString:
+            return copy_string(data, length, out);
+
+        case LsResource::TypeTranslatedString:
+        case LsResource::TypeTranslatedFSString: {
+            // BG3 files carry a version before the handle, older ones a value
+            quint32 pos = 0;
+            if (version >= 4) {
+                pos = 2;
+            } else {
+                if (length < 4 || qFromLittleEndian<quint32>(data) > length - 4) {
+                    return 0;
+                }
+                pos = 4 + qFromLittleEndian<quint32>(data);
+            }
+            if (pos + 4 > length) {
+                return 0;
+            }
+            quint32 handle_length = qFromLittleEndian<quint32>(data + pos);
+            if (handle_length > length - pos - 4) {
+                return 0;
+            }
+            return copy_string(data + pos + 4, handle_length, out);
+        }
+
+        case LsResource::TypeGuid: {
+            if (length < 16) {
+                return 0;
+            }
+            // The last eight bytes are stored as byte-swapped pairs
+            return std::snprintf(out, 40, "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                                 qFromLittleEndian<quint32>(data), qFromLittleEndian<quint16>(data + 4),
+                                 qFromLittleEndian<quint16>(data + 6), data[9], data[8],
+                                 data[11], data[10], data[13], data[12], data[15], data[14]);
+        }
+
+        case LsResource::TypeBool:
+            if (length < 1) {
+                return 0;
+            }
+            return copy_string(reinterpret_cast<const uchar *>(data[0] ? "True" : "False"), data[0] ? 4 : 5, out);
+
+        case LsResource::TypeScratchBuffer: {
+            QByteArray encoded = QByteArray::fromRawData(reinterpret_cast<const char *>(data), length).toBase64();
+            memcpy(out, encoded.constData(), size_t(encoded.size()));
+            return encoded.size();
+        }
+
+        default:
+            break;
+    }
+
+    char *start = out;
+    auto scalar = [&](int scalar_type, const uchar *p) {
+        switch (scalar_type) {
+            case LsResource::TypeUInt8: return std::snprintf(out, 32, "%u", unsigned(p[0]));
+            case LsResource::TypeInt8: return std::snprintf(out, 32, "%d", int(qint8(p[0])));
+            case LsResource::TypeInt16: return std::snprintf(out, 32, "%d", int(qFromLittleEndian<qint16>(p)));
+            case LsResource::TypeUInt16: return std::snprintf(out, 32, "%u", unsigned(qFromLittleEndian<quint16>(p)));
+            case LsResource::TypeInt32: return std::snprintf(out, 32, "%d", qFromLittleEndian<qint32>(p));
+            case LsResource::TypeUInt32: return std::snprintf(out, 32, "%u", qFromLittleEndian<quint32>(p));
+            case LsResource::TypeFloat: {
+                float value = qFromLittleEndian<float>(p);
+                return std::snprintf(out, 32, "%.9g", double(value));
+            }
+            case LsResource::TypeDouble: return std::snprintf(out, 32, "%.17g", qFromLittleEndian<double>(p));
+            case LsResource::TypeUInt64: return std::snprintf(out, 32, "%llu", static_cast<unsigned long long>(qFromLittleEndian<quint64>(p)));
+            default: return std::snprintf(out, 32, "%lld", static_cast<long long>(qFromLittleEndian<qint64>(p)));
+        }
+    };
+    auto scalar_size = [](int scalar_type) {
+        switch (scalar_type) {
+            case LsResource::TypeUInt8: case LsResource::TypeInt8: return 1u;
+            case LsResource::TypeInt16: case LsResource::TypeUInt16: return 2u;
+            case LsResource::TypeInt32: case LsResource::TypeUInt32: case LsResource::TypeFloat: return 4u;
+            default: return 8u;
+        }
+    };
+
+    int components = vector_components(type);
+    if (components > 0) {
+        int component_type = type <= LsResource::TypeIVec4 ? LsResource::TypeInt32 : LsResource::TypeFloat;
+        if (length < quint32(components) * 4) {
+            return 0;
+        }
+        for (int i = 0; i < components; ++i) {
+            if (i > 0) {
+                *out++ = ' ';
+            }
+            out += scalar(component_type, data + i * 4);
+        }
+        return out - start;
+    }
+
+    switch (type) {
+        case LsResource::TypeUInt8: case LsResource::TypeInt8:
+        case LsResource::TypeInt16: case LsResource::TypeUInt16:
+        case LsResource::TypeInt32: case LsResource::TypeUInt32:
+        case LsResource::TypeFloat: case LsResource::TypeDouble:
+        case LsResource::TypeUInt64: case LsResource::TypeOldInt64: case LsResource::TypeInt64:
+            return length >= scalar_size(type) ? scalar(type, data) : 0;
+        default:
+            return 0;
+    }
+}
+
+// Decodes the predefined entities and character references in place.
+qsizetype unescape(char *text, qsizetype length) {
+    char *out = text;
+    const char *end = text + length;
+    for (const char *p = text; p < end; ++p) {
+        if (*p != '&') {
+            *out++ = *p;
+            continue;
+        }
+        const char *semicolon = static_cast<const char *>(memchr(p, ';', size_t(end - p)));
+        if (!semicolon) {
+            *out++ = *p;
+            continue;
+        }
+        QByteArrayView entity(p + 1, semicolon - p - 1);
+        if (same(entity, "amp")) {
+            *out++ = '&';
+        } else if (same(entity, "lt")) {
+            *out++ = '<';
+        } else if (same(entity, "gt")) {
+            *out++ = '>';
+        } else if (same(entity, "quot")) {
+            *out++ = '"';
+        } else if (same(entity, "apos")) {
+            *out++ = '\'';
+        } else if (entity.startsWith('#')) {
+            bool ok = false;
+            QByteArray digits = entity.toByteArray();
+            uint code = digits.startsWith("#x") ? digits.mid(2).toUInt(&ok, 16) : digits.mid(1).toUInt(&ok, 10);
+            if (!ok) {
+                continue;
+            }
+            // Never longer than the reference itself
+            char32_t character = char32_t(code);
+            QByteArray utf8 = QString::fromUcs4(&character, 1).toUtf8();
+            memcpy(out, utf8.constData(), size_t(utf8.size()));
+            out += utf8.size();
+        } else {
+            memmove(out, p, size_t(semicolon - p + 1));
+            out += semicolon - p + 1;
+        }
+        p = semicolon;
+    }
+    return out - text;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+}
+
+LsResource::LsResource() : nodes(nullptr), attributes(nullptr), nodes_used(0), attributes_used(0), first_root(-1) {
+}
+
+bool LsResource::read(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Unable to open " + path + ": " + file.errorString();
+        return false;
+    }
+
+    qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (data) {
+        return parse(QByteArrayView(reinterpret_cast<const char *>(data), size));
+    }
+    return parse(file.readAll());
+}
+
+bool LsResource::parse(QByteArrayView data) {
+    arena.reset();
+    nodes = nullptr;
+    attributes = nullptr;
+    nodes_used = 0;
+    attributes_used = 0;
+    first_root = -1;
+    error.clear();
+
+    if (data.size() >= 4 && qFromLittleEndian<quint32>(data.data()) == lsf_signature) {
+        return parse_lsf(data);
+    }
+    return parse_lsx(data);
+}
+
+QString LsResource::error_string() const {
+    return error;
+}
+
+char *LsResource::allocate(int node_total, int attribute_total, qsizetype text_size) {
+    qsizetype node_bytes = qsizetype(node_total) * qsizetype(sizeof(Node));
+    qsizetype attribute_bytes = qsizetype(attribute_total) * qsizetype(sizeof(Attribute));
+    arena.reset(new char[size_t(node_bytes + attribute_bytes + text_size)]);
+
+    nodes = reinterpret_cast<Node *>(arena.get());
+    for (int i = 0; i < node_total; ++i) {
+        new (nodes + i) Node();
+    }
+    attributes = reinterpret_cast<Attribute *>(arena.get() + node_bytes);
+    for (int i = 0; i < attribute_total; ++i) {
+        new (attributes + i) Attribute();
+    }
+    return arena.get() + node_bytes + attribute_bytes;
+}
+
+void LsResource::link_nodes() {
+    // Children keep their file order
+    std::vector<int> last_child(size_t(nodes_used), -1);
+    int last_root = -1;
+    for (int i = 0; i < nodes_used; ++i) {
+        int parent = nodes[i].parent;
+        int &previous = parent < 0 ? last_root : last_child[size_t(parent)];
+        if (previous < 0) {
+            (parent < 0 ? first_root : nodes[parent].first_child) = i;
+        } else {
+            nodes[previous].next_sibling = i;
+        }
+        previous = i;
+    }
+}
+
+bool LsResource::parse_lsf(QByteArrayView data) {
+    const uchar *base = reinterpret_cast<const uchar *>(data.data());
+    qsizetype size = data.size();
+    if (size < 8) {
+        error = "Truncated LSF header";
+        return false;
+    }
+
+    quint32 version = qFromLittleEndian<quint32>(base + 4);
+    qsizetype pos = 8 + (version >= 5 ? 8 : 4);  // 64-bit engine version since BG3 v5
+    // v6 added a keys section, stored after the values
+    int size_fields = version >= 6 ? 10 : 8;
+    if (pos + size_fields * 4 + 8 > size) {
+        error = "Truncated LSF header";
+        return false;
+    }
+    quint32 sizes[10];
+    for (int i = 0; i < size_fields; ++i) {
+        sizes[i] = qFromLittleEndian<quint32>(base + pos + i * 4);
+    }
+    uchar compression = base[pos + size_fields * 4];
+    quint32 format = qFromLittleEndian<quint32>(base + pos + size_fields * 4 + 4);
+    pos += size_fields * 4 + 8;
+
+    auto section = [&](quint32 uncompressed, quint32 on_disk, bool chunked, QByteArray &out) {
+        int method = compression & 0x0F;
+        bool stored = on_disk == 0 || method == 0;
+        qsizetype length = stored ? uncompressed : on_disk;
+        if (length > size - pos) {
+            error = "Truncated LSF section";
+            return false;
+        }
+        QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char *>(base + pos), length);
+        pos += length;
+        if (stored) {
+            out = QByteArray(raw.constData(), raw.size());
+        } else if (method == compression_zlib) {
+            out.resize(uncompressed);
+            uLongf out_size = uncompressed;
+            if (uncompress(reinterpret_cast<Bytef *>(out.data()), &out_size, reinterpret_cast<const Bytef *>(raw.constData()), uLong(raw.size())) != Z_OK) {
+                out.clear();
+            }
+        } else if (method == compression_lz4) {
+            // Sections other than the string table are LZ4 frames since v2
+            out = chunked && version >= 2 ? Lz4Block::decompress_frame(raw, uncompressed) : Lz4Block::decompress(raw, uncompressed);
+        } else {
+            error = QString("Unsupported LSF compression method %1").arg(method);
+            return false;
+        }
+        if (out.size() != qsizetype(uncompressed)) {
+            error = "Corrupt LSF section";
+            return false;
+        }
+        return true;
+    };
+
+    int nodes_size = version >= 6 ? 4 : 2;
+    QByteArray names, node_data, attribute_data, values;
+    if (!section(sizes[0], sizes[1], false, names)
+        || !section(sizes[nodes_size], sizes[nodes_size + 1], true, node_data)
+        || !section(sizes[nodes_size + 2], sizes[nodes_size + 3], true, attribute_data)
+        || !section(sizes[nodes_size + 4], sizes[nodes_size + 5], true, values)) {
+        return false;
+    }
+
+    // Name table: hash buckets of length-prefixed strings
+    std::vector<std::vector<QByteArrayView>> name_table;
+    qsizetype names_total = 0;
+    {
+        const uchar *p = reinterpret_cast<const uchar *>(names.constData());
+        const uchar *end = p + names.size();
+        if (end - p < 4) {
+            error = "Corrupt LSF name table";
+            return false;
+        }
+        quint32 buckets = qFromLittleEndian<quint32>(p);
+        p += 4;
+        name_table.resize(buckets);
+        for (quint32 b = 0; b < buckets; ++b) {
+            if (end - p < 2) {
+                error = "Corrupt LSF name table";
+                return false;
+            }
+            quint16 count = qFromLittleEndian<quint16>(p);
+            p += 2;
+            for (quint16 n = 0; n < count; ++n) {
+                if (end - p < 2 || qFromLittleEndian<quint16>(p) > end - p - 2) {
+                    error = "Corrupt LSF name table";
+                    return false;
+                }
+                quint16 length = qFromLittleEndian<quint16>(p);
+                name_table[b].push_back(QByteArrayView(reinterpret_cast<const char *>(p + 2), length));
+                names_total += length;
+                p += 2 + length;
+            }
+        }
+    }
+
+    bool extended = version >= 3 && format == lsf_extended_format;
+    int node_record = extended ? 16 : 12;
+    int attribute_record = extended ? 16 : 12;
+    int node_total = int(node_data.size() / node_record);
+    int attribute_total = int(attribute_data.size() / attribute_record);
+    const uchar *node_base = reinterpret_cast<const uchar *>(node_data.constData());
+    const uchar *attribute_base = reinterpret_cast<const uchar *>(attribute_data.constData());
+
+    qsizetype text_size = names_total;
+    for (int i = 0; i < attribute_total; ++i) {
+        text_size += text_bound(qFromLittleEndian<quint32>(attribute_base + i * attribute_record + 4) >> 6);
+    }
+    char *text = allocate(node_total, attribute_total, text_size);
+
+    // Names move into the arena so nothing points into the temporary sections
+    for (auto &bucket : name_table) {
+        for (QByteArrayView &name : bucket) {
+            memcpy(text, name.data(), size_t(name.size()));
+            name = QByteArrayView(text, name.size());
+            text += name.size();
+        }
+    }
+    auto resolve = [&name_table](quint32 index, QByteArrayView &name) {
+        quint32 bucket = index >> 16;
+        quint32 offset = index & 0xFFFF;
+        if (bucket >= name_table.size() || offset >= name_table[bucket].size()) {
+            return false;
+        }
+        name = name_table[bucket][offset];
+        return true;
+    };
+
+    for (int i = 0; i < node_total; ++i) {
+        const uchar *record = node_base + i * node_record;
+        Node &node = nodes[i];
+        qint32 parent = qFromLittleEndian<qint32>(record + (extended ? 4 : 8));
+        node.first_attribute = qFromLittleEndian<qint32>(record + (extended ? 12 : 4));
+        if (!resolve(qFromLittleEndian<quint32>(record), node.name) || parent >= i || parent < -1
+            || node.first_attribute >= attribute_total || node.first_attribute < -1) {
+            error = "Corrupt LSF node table";
+            return false;
+        }
+        node.parent = parent;
+    }
+    nodes_used = node_total;
+
+    std::vector<int> last_attribute(size_t(node_total), -1);
+    quint32 data_offset = 0;
+    for (int i = 0; i < attribute_total; ++i) {
+        const uchar *record = attribute_base + i * attribute_record;
+        Attribute &attribute = attributes[i];
+        quint32 type_and_length = qFromLittleEndian<quint32>(record + 4);
+        quint32 length = type_and_length >> 6;
+        attribute.type = int(type_and_length & 0x3F);
+        if (extended) {
+            attribute.next = qFromLittleEndian<qint32>(record + 8);
+            data_offset = qFromLittleEndian<quint32>(record + 12);
+        } else {
+            // Older records name their node instead of the next attribute
+            qint32 owner = qFromLittleEndian<qint32>(record + 8);
+            if (owner < 0 || owner >= node_total) {
+                error = "Corrupt LSF attribute table";
+                return false;
+            }
+            if (last_attribute[size_t(owner)] >= 0) {
+                attributes[last_attribute[size_t(owner)]].next = i;
+            }
+            last_attribute[size_t(owner)] = i;
+        }
+        if (!resolve(qFromLittleEndian<quint32>(record), attribute.name) || attribute.next >= attribute_total
+            || data_offset > quint32(values.size()) || length > quint32(values.size()) - data_offset) {
+            error = "Corrupt LSF attribute table";
+            return false;
+        }
+
+        const uchar *value = reinterpret_cast<const uchar *>(values.constData()) + data_offset;
+        qsizetype written = format_value(attribute.type, value, length, version, text);
+        attribute.value = QByteArrayView(text, written);
+        text += written;
+        data_offset += length;
+    }
+    attributes_used = attribute_total;
+
+    link_nodes();
+    return true;
+}
+
+bool LsResource::parse_lsx(QByteArrayView data) {
+    const char *begin = data.data();
+    const char *end = begin + data.size();
+
+    // Count first so everything fits in one allocation
+    int node_total = 0;
+    int attribute_total = 0;
+    for (const char *p = begin; (p = static_cast<const char *>(memchr(p, '<', size_t(end - p)))); ++p) {
+        QByteArrayView rest(p + 1, qMin<qsizetype>(end - p - 1, 10));
+        if (rest.startsWith("node") || rest.startsWith("region")) {
+            node_total++;
+        } else if (rest.startsWith("attribute")) {
+            attribute_total++;
+        }
+    }
+
+    char *text = allocate(node_total, attribute_total, data.size());
+    memcpy(text, begin, size_t(data.size()));
+    char *p = text;
+    char *text_end = text + data.size();
+
+    std::vector<int> stack;
+    std::vector<int> last_attribute(size_t(node_total), -1);
+    while ((p = static_cast<char *>(memchr(p, '<', size_t(text_end - p))))) {
+        ++p;
+        if (p < text_end && (*p == '?' || *p == '!')) {
+            // Declaration or comment
+            bool comment = text_end - p > 2 && p[1] == '-' && p[2] == '-';
+            char *close = p;
+            while ((close = static_cast<char *>(memchr(close, '>', size_t(text_end - close))))) {
+                if (!comment || (close - p >= 4 && close[-1] == '-' && close[-2] == '-')) {
+                    break;
+                }
+                ++close;
+            }
+            if (!close) {
+                break;
+            }
+            p = close + 1;
+            continue;
+        }
+
+        bool closing = p < text_end && *p == '/';
+        if (closing) {
+            ++p;
+        }
+        char *name_start = p;
+        while (p < text_end && !is_space(*p) && *p != '>' && *p != '/') {
+            ++p;
+        }
+        QByteArrayView name(name_start, p - name_start);
+        bool is_node = same(name, "node") || same(name, "region");
+        bool is_attribute = same(name, "attribute");
+
+        QByteArrayView id, type, value, handle;
+        bool has_value = false;
+        bool self_closing = false;
+        while (true) {
+            while (p < text_end && is_space(*p)) {
+                ++p;
+            }
+            if (p >= text_end) {
+                error = "Truncated tag in LSX resource";
+                return false;
+            }
+            if (*p == '>') {
+                ++p;
+                break;
+            }
+            if (*p == '/') {
+                self_closing = true;
+                ++p;
+                continue;
+            }
+
+            char *key_start = p;
+            while (p < text_end && *p != '=' && *p != '>' && !is_space(*p)) {
+                ++p;
+            }
+            QByteArrayView key(key_start, p - key_start);
+            while (p < text_end && is_space(*p)) {
+                ++p;
+            }
+            if (p >= text_end || *p != '=') {
+                continue;
+            }
+            ++p;
+            while (p < text_end && is_space(*p)) {
+                ++p;
+            }
+            if (p >= text_end || (*p != '"' && *p != '\'')) {
+                error = "Malformed attribute in LSX resource";
+                return false;
+            }
+            char quote = *p++;
+            char *value_start = p;
+            while (p < text_end && *p != quote) {
+                ++p;
+            }
+            if (p >= text_end) {
+                error = "Truncated tag in LSX resource";
+                return false;
+            }
+            QByteArrayView unescaped(value_start, unescape(value_start, p - value_start));
+            ++p;
+
+            if (same(key, "id")) {
+                id = unescaped;
+            } else if (same(key, "type")) {
+                type = unescaped;
+            } else if (same(key, "value")) {
+                value = unescaped;
+                has_value = true;
+            } else if (same(key, "handle")) {
+                handle = unescaped;
+            }
+        }
+
+        if (is_node) {
+            if (closing) {
+                if (!stack.empty()) {
+                    stack.pop_back();
+                }
+                continue;
+            }
+            if (nodes_used == node_total) {
+                continue;
+            }
+            Node &node = nodes[nodes_used];
+            node.name = id;
+            node.parent = stack.empty() ? -1 : stack.back();
+            if (!self_closing) {
+                stack.push_back(nodes_used);
+            }
+            nodes_used++;
+        } else if (is_attribute && !closing && !stack.empty() && attributes_used < attribute_total) {
+            Attribute &attribute = attributes[attributes_used];
+            attribute.name = id;
+            attribute.type = type_from_name(type);
+            attribute.value = has_value ? value : handle;
+            int owner = stack.back();
+            if (last_attribute[size_t(owner)] < 0) {
+                nodes[owner].first_attribute = attributes_used;
+            } else {
+                attributes[last_attribute[size_t(owner)]].next = attributes_used;
+            }
+            last_attribute[size_t(owner)] = attributes_used;
+            attributes_used++;
+        }
+    }
+
+    link_nodes();
+    return true;
+}
+
+int LsResource::node_count() const {
+    return nodes_used;
+}
+
+const LsResource::Node &LsResource::node(int index) const {
+    return nodes[index];
+}
+
+const LsResource::Attribute &LsResource::attribute(int index) const {
+    return attributes[index];
+}
+
+int LsResource::child_named(int node, QByteArrayView name) const {
+    int index = node < 0 ? first_root : nodes[node].first_child;
+    while (index >= 0) {
+        if (same(nodes[index].name, name)) {
+            return index;
+        }
+        index = nodes[index].next_sibling;
+    }
+    return -1;
+}
+
+int LsResource::child(int node, const char *name) const {
+    return child_named(node, QByteArrayView(name, qsizetype(strlen(name))));
+}
+
+int LsResource::find(const char *path) const {
+    int node = -1;
+    const char *p = path;
+    while (true) {
+        const char *slash = strchr(p, '/');
+        qsizetype length = slash ? slash - p : qsizetype(strlen(p));
+        node = child_named(node, QByteArrayView(p, length));
+        if (node < 0 || !slash) {
+            return node;
+        }
+        p = slash + 1;
+    }
+}
+
+QByteArrayView LsResource::value(int node, const char *attribute) const {
+    if (node < 0 || node >= nodes_used) {
+        return QByteArrayView();
+    }
+    QByteArrayView name(attribute, qsizetype(strlen(attribute)));
+    for (int index = nodes[node].first_attribute; index >= 0; index = attributes[index].next) {
+        if (same(attributes[index].name, name)) {
+            return attributes[index].value;
+        }
+    }
+    return QByteArrayView();
+}
+
+QString LsResource::string(int node, const char *attribute) const {
+    return QString::fromUtf8(value(node, attribute));
+}
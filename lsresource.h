@@ -0,0 +1,104 @@
+#ifndef LSRESOURCE_H
+#define LSRESOURCE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
+#include <memory>
+
+// Read-only view of a Larian resource file, binary .lsf or XML .lsx, such as
+// a mod's meta.lsx. Regions are the top-level nodes (Config/root/...). All
+// nodes, attributes and their text live in a single arena allocation owned by
+// the resource, so a parse costs one allocation and the views stay valid
+// until the next parse.
+class LsResource {
+public:
+    enum Type {
+        TypeNone,
+        TypeUInt8,
+        TypeInt16,
+        TypeUInt16,
+        TypeInt32,
+        TypeUInt32,
+        TypeFloat,
+        TypeDouble,
+        TypeIVec2,
+        TypeIVec3,
+        TypeIVec4,
+        TypeVec2,
+        TypeVec3,
+        TypeVec4,
+        TypeMat2,
+        TypeMat3,
+        TypeMat3x4,
+        TypeMat4x3,
+        TypeMat4,
+        TypeBool,
+        TypeString,
+        TypePath,
+        TypeFixedString,
+        TypeLSString,
+        TypeUInt64,
+        TypeScratchBuffer,
+        TypeOldInt64,
+        TypeInt8,
+        TypeTranslatedString,
+        TypeWString,
+        TypeLSWString,
+        TypeGuid,
+        TypeInt64,
+        TypeTranslatedFSString,
+        TypeCount
+    };
+
+    struct Attribute {
+        QByteArrayView name;
+        QByteArrayView value;  // as written in .lsx; the handle for translated strings
+        int type = TypeNone;
+        int next = -1;
+    };
+
+    struct Node {
+        QByteArrayView name;
+        int parent = -1;
+        int first_child = -1;
+        int next_sibling = -1;
+        int first_attribute = -1;
+    };
+
+    LsResource();
+    bool read(const QString &path);
+    // Binary if data starts with the LSOF signature, XML otherwise.
+    bool parse(QByteArrayView data);
+    QString error_string() const;
+
+    int node_count() const;
+    const Node &node(int index) const;
+    const Attribute &attribute(int index) const;
+
+    // First node along a path of node names such as "Config/root/ModuleInfo",
+    // or -1.
+    int find(const char *path) const;
+    // First child of node (or region, for node -1) with the given name, or -1.
+    int child(int node, const char *name) const;
+    QByteArrayView value(int node, const char *attribute) const;
+    QString string(int node, const char *attribute) const;
+
+private:
+    bool parse_lsf(QByteArrayView data);
+    bool parse_lsx(QByteArrayView data);
+    char *allocate(int node_total, int attribute_total, qsizetype text_size);
+    void link_nodes();
+    int child_named(int node, QByteArrayView name) const;
+
+    std::unique_ptr<char[]> arena;
+    Node *nodes;
+    Attribute *attributes;
+    int nodes_used;
+    int attributes_used;
+    int first_root;
+    QString error;
+};
+
+#endif
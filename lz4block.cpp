@@ -0,0 +1,250 @@
+#include "lz4block.h"
+#include <QtEndian>
+#include <cstring>
+#include <vector>
+
+static const int min_match = 4;
+// The last match must start at least 12 bytes before the end of the block and
+// the last 5 bytes are always literals, so decoders can copy in wide words.
+static const int match_search_limit = 12;
+static const int last_literals = 5;
+static const int hash_bits = 16;
+static const int max_offset = 65535;
+
+qint64 Lz4Block::decompress(const char *src, qint64 src_size, char *dst, qint64 dst_capacity, qint64 history) {
+    const uchar *ip = reinterpret_cast<const uchar *>(src);
+    const uchar *const ip_end = ip + src_size;
+    uchar *op = reinterpret_cast<uchar *>(dst);
+    uchar *const op_start = op;
+    const uchar *const window_start = op - history;
+    uchar *const op_end = op + dst_capacity;
+
+    while (ip < ip_end) {
+        uchar token = *ip++;
+
+        qint64 literal_length = token >> 4;
+        if (literal_length == 15) {
+            uchar extra;
+            do {
+                if (ip >= ip_end) {
+                    return -1;
+                }
+                extra = *ip++;
+                literal_length += extra;
+            } while (extra == 255);
+        }
+        if (literal_length > ip_end - ip || literal_length > op_end - op) {
+            return -1;
+        }
+        memcpy(op, ip, size_t(literal_length));
+        ip += literal_length;
+        op += literal_length;
+
+        if (ip >= ip_end) {
+            break;  // The last sequence has literals only
+        }
+
+        if (ip_end - ip < 2) {
+            return -1;
+        }
+        qint64 offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - window_start) {
+            return -1;
+        }
+
+        qint64 match_length = token & 15;
+        if (match_length == 15) {
+            uchar extra;
+            do {
+                if (ip >= ip_end) {
+                    return -1;
+                }
+                extra = *ip++;
+                match_length += extra;
+            } while (extra == 255);
+        }
+        match_length += min_match;
+        if (match_length > op_end - op) {
+            return -1;
+        }
+
+        // Matches may overlap their own output, so copy forwards byte by byte
+        // unless the source is far enough behind.
+        const uchar *match = op - offset;
+        if (offset >= match_length) {
+            memcpy(op, match, size_t(match_length));
+            op += match_length;
+        } else {
+            for (qint64 i = 0; i < match_length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op - op_start;
+}
+
+static quint32 read32(const uchar *p) {
+    quint32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static quint32 hash_sequence(quint32 sequence) {
+    return (sequence * 2654435761U) >> (32 - hash_bits);
+}
+
+static uchar *write_length(uchar *op, qint64 length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = uchar(length);
+    return op;
+}
+
+static uchar *write_sequence(uchar *op, const uchar *literals, qint64 literal_length, qint64 offset, qint64 match_length) {
+    uchar *token = op++;
+    *token = uchar(qMin<qint64>(literal_length, 15) << 4);
+    if (literal_length >= 15) {
+        op = write_length(op, literal_length - 15);
+    }
+    memcpy(op, literals, size_t(literal_length));
+    op += literal_length;
+
+    if (match_length > 0) {
+        *op++ = uchar(offset);
+        *op++ = uchar(offset >> 8);
+        qint64 length_code = match_length - min_match;
+        *token |= uchar(qMin<qint64>(length_code, 15));
+        if (length_code >= 15) {
+            op = write_length(op, length_code - 15);
+        }
+    }
+    return op;
+}
+
+qint64 Lz4Block::compress_bound(qint64 src_size) {
+    return src_size + src_size / 255 + 16;
+}
+
+qint64 Lz4Block::compress(const char *src, qint64 src_size, char *dst) {
+    const uchar *const base = reinterpret_cast<const uchar *>(src);
+    uchar *op = reinterpret_cast<uchar *>(dst);
+    uchar *const op_start = op;
+    const uchar *anchor = base;
+
+    if (src_size > match_search_limit) {
+        const uchar *const search_end = base + src_size - match_search_limit;
+        const uchar *const match_end = base + src_size - last_literals;
+        std::vector<qint64> table(size_t(1) << hash_bits, -1);
+
+        const uchar *ip = base;
+        int misses = 0;
+        while (ip < search_end) {
+            quint32 sequence = read32(ip);
+            quint32 h = hash_sequence(sequence);
+            qint64 candidate = table[h];
+            table[h] = ip - base;
+
+            const uchar *ref = base + candidate;
+            if (candidate < 0 || ip - ref > max_offset || read32(ref) != sequence) {
+                // Skip ahead faster through incompressible data
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const uchar *end = ip + min_match;
+            const uchar *match = ref + min_match;
+            while (end < match_end && *end == *match) {
+                ++end;
+                ++match;
+            }
+
+            op = write_sequence(op, anchor, ip - anchor, ip - ref, end - ip);
+            ip = end;
+            anchor = ip;
+            if (ip - 2 >= base && ip - 2 < search_end) {
+                table[hash_sequence(read32(ip - 2))] = ip - 2 - base;
+            }
+        }
+    }
+
+    op = write_sequence(op, anchor, base + src_size - anchor, 0, 0);
+    return op - op_start;
+}
+
+QByteArray Lz4Block::compress(const QByteArray &src) {
+    QByteArray output(compress_bound(src.size()), Qt::Uninitialized);
+    output.truncate(compress(src.constData(), src.size(), output.data()));
+    return output;
+}
+
+QByteArray Lz4Block::decompress(const QByteArray &src, qint64 uncompressed_size) {
+    QByteArray output(uncompressed_size, Qt::Uninitialized);
+    qint64 written = decompress(src.constData(), src.size(), output.data(), output.size());
+    if (written < 0) {
+        return QByteArray();
+    }
+    output.truncate(written);
+    return output;
+}
+
+QByteArray Lz4Block::decompress_frame(const QByteArray &src, qint64 uncompressed_size) {
+    const uchar *ip = reinterpret_cast<const uchar *>(src.constData());
+    const uchar *const ip_end = ip + src.size();
+    if (src.size() < 7 || qFromLittleEndian<quint32>(ip) != 0x184D2204) {
+        return QByteArray();
+    }
+
+    uchar flags = ip[4];
+    bool block_checksums = flags & 0x10;
+    bool content_size = flags & 0x08;
+    bool dictionary = flags & 0x01;
+    ip += 6 + (content_size ? 8 : 0) + (dictionary ? 4 : 0) + 1;  // magic, FLG, BD, options, header checksum
+
+    QByteArray output(uncompressed_size, Qt::Uninitialized);
+    char *op = output.data();
+    qint64 written = 0;
+    while (true) {
+        if (ip_end - ip < 4) {
+            return QByteArray();
+        }
+        quint32 block_size = qFromLittleEndian<quint32>(ip);
+        ip += 4;
+        if (block_size == 0) {
+            break;  // end mark, an optional content checksum follows
+        }
+
+        bool stored = block_size & 0x80000000U;
+        block_size &= 0x7FFFFFFFU;
+        if (block_size > quint64(ip_end - ip)) {
+            return QByteArray();
+        }
+        qint64 block_written;
+        if (stored) {
+            if (block_size > quint64(output.size() - written)) {
+                return QByteArray();
+            }
+            memcpy(op + written, ip, block_size);
+            block_written = block_size;
+        } else {
+            // Linked blocks may refer to anything decoded so far
+            block_written = decompress(reinterpret_cast<const char *>(ip), block_size, op + written, output.size() - written, written);
+            if (block_written < 0) {
+                return QByteArray();
+            }
+        }
+        written += block_written;
+        ip += block_size + (block_checksums ? 4 : 0);
+    }
+
+    output.truncate(written);
+    return output;
+}
@@ -0,0 +1,26 @@
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include <QByteArray>
+
+// LZ4 block format (no frame header), as used for LSPK file tables and entries.
+class Lz4Block {
+public:
+    // Returns the number of bytes written to dst, or -1 if the input is
+    // malformed or does not fit into dst_capacity. Matches may reach back into
+    // the history bytes directly before dst (linked blocks of a frame).
+    static qint64 decompress(const char *src, qint64 src_size, char *dst, qint64 dst_capacity, qint64 history = 0);
+    static QByteArray decompress(const QByteArray &src, qint64 uncompressed_size);
+    // LZ4 frame format (magic 0x184D2204), as LSF resources store their
+    // node, attribute and value sections. Checksums are not verified.
+    static QByteArray decompress_frame(const QByteArray &src, qint64 uncompressed_size);
+
+    // Greedy single-probe compressor, the same trade-off as LZ4's fast mode.
+    // dst must hold at least compress_bound(src_size) bytes; returns the
+    // compressed size.
+    static qint64 compress(const char *src, qint64 src_size, char *dst);
+    static QByteArray compress(const QByteArray &src);
+    static qint64 compress_bound(qint64 src_size);
+};
+
+#endif
@@ -1,7 +1,12 @@
 #include <QApplication>
 #include "moddingtoolsui.h"
+#include "cli.h"
 
 int main(int argc, char *argv[]) {
+    if (isCommandLineInvocation(argc, argv)) {
+        return runCommandLine(argc, argv);
+    }
+
     QApplication app(argc, argv);
     ModdingToolsUI window;
     window.show();
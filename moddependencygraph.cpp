@@ -0,0 +1,151 @@
+#include "moddependencygraph.h"
+#include "modsettings.h"
+#include <QSet>
+#include <algorithm>
+
+void ModDependencyGraph::build(const QVector<Mod> &mods) {
+    int count = int(mods.size());
+    jobs.clear();
+    job_index.clear();
+    edges = QVector<QVector<int>>(count);
+    missing_dependencies = QVector<QVector<Missing>>(count);
+    sorted.clear();
+    in_cycle = QVector<bool>(count, false);
+    component = QVector<int>(count, -1);
+
+    // The first mod providing a module wins, as in the load order
+    QHash<QString, int> provider;
+    for (int i = 0; i < count; ++i) {
+        jobs << mods[i].job;
+        job_index.insert(mods[i].job, i);
+        for (const ModuleMeta &module : mods[i].modules) {
+            if (!provider.contains(module.uuid.toLower())) {
+                provider.insert(module.uuid.toLower(), i);
+            }
+        }
+    }
+
+    // stamp[j] == i marks an edge i -> j as already added
+    QVector<int> stamp(count, -1);
+    for (int i = 0; i < count; ++i) {
+        QSet<QString> reported;
+        for (const ModuleMeta &module : mods[i].modules) {
+            for (int d = 0; d < module.dependencies.size(); ++d) {
+                const QString &uuid = module.dependencies[d];
+                if (ModSettings::is_builtin_uuid(uuid)) {
+                    continue;
+                }
+                int dependency = provider.value(uuid.toLower(), -1);
+                if (dependency < 0) {
+                    if (!reported.contains(uuid.toLower())) {
+                        reported.insert(uuid.toLower());
+                        missing_dependencies[i] << Missing{uuid, module.dependency_names.value(d)};
+                    }
+                } else if (dependency != i && stamp[dependency] != i) {
+                    stamp[dependency] = i;
+                    edges[i] << dependency;
+                }
+            }
+        }
+    }
+
+    // Tarjan's strongly connected components, iteratively. A component is
+    // completed only after every component it depends on, so the completion
+    // order is a valid scan order with each cycle kept together.
+    QVector<int> index(count, -1);
+    QVector<int> low(count, 0);
+    QVector<bool> on_stack(count, false);
+    QVector<int> stack;
+    QVector<QPair<int, int>> calls;  // {mod, next edge}
+    int next_index = 0;
+    int components = 0;
+    for (int root = 0; root < count; ++root) {
+        if (index[root] >= 0) {
+            continue;
+        }
+        index[root] = low[root] = next_index++;
+        stack << root;
+        on_stack[root] = true;
+        calls << qMakePair(root, 0);
+        while (!calls.isEmpty()) {
+            int mod = calls.last().first;
+            int edge = calls.last().second;
+            if (edge < edges[mod].size()) {
+                calls.last().second++;
+                int dependency = edges[mod][edge];
+                if (index[dependency] < 0) {
+                    index[dependency] = low[dependency] = next_index++;
+                    stack << dependency;
+                    on_stack[dependency] = true;
+                    calls << qMakePair(dependency, 0);
+                } else if (on_stack[dependency]) {
+                    low[mod] = qMin(low[mod], index[dependency]);
+                }
+                continue;
+            }
+
+            calls.removeLast();
+            if (!calls.isEmpty()) {
+                int parent = calls.last().first;
+                low[parent] = qMin(low[parent], low[mod]);
+            }
+            if (low[mod] != index[mod]) {
+                continue;
+            }
+            QVector<int> members;
+            int member = -1;
+            do {
+                member = stack.takeLast();
+                on_stack[member] = false;
+                component[member] = components;
+                members << member;
+            } while (member != mod);
+            components++;
+
+            std::sort(members.begin(), members.end());  // list order within a cycle
+            for (int m : members) {
+                in_cycle[m] = members.size() > 1;
+                sorted << jobs[m];
+            }
+        }
+    }
+}
+
+int ModDependencyGraph::size() const {
+    return int(jobs.size());
+}
+
+QStringList ModDependencyGraph::order() const {
+    return sorted;
+}
+
+QStringList ModDependencyGraph::cyclic() const {
+    QStringList result;
+    for (int i = 0; i < jobs.size(); ++i) {
+        if (in_cycle[i]) {
+            result << jobs[i];
+        }
+    }
+    return result;
+}
+
+QHash<QString, QStringList> ModDependencyGraph::dependencies() const {
+    QHash<QString, QStringList> result;
+    for (int i = 0; i < jobs.size(); ++i) {
+        QStringList waits_for;
+        for (int dependency : edges[i]) {
+            if (component[i] != component[dependency]) {
+                waits_for << jobs[dependency];
+            }
+        }
+        if (!waits_for.isEmpty()) {
+            result.insert(jobs[i], waits_for);
+        }
+    }
+    return result;
+}
+
+QVector<ModDependencyGraph::Missing> ModDependencyGraph::missing(const QString &job) const {
+    int index = job_index.value(job, -1);
+    return index < 0 ? QVector<Missing>() : missing_dependencies[index];
+}
@@ -0,0 +1,47 @@
+#ifndef MODDEPENDENCYGRAPH_H
+#define MODDEPENDENCYGRAPH_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include "pakresultcache.h"
+
+// Dependencies between the mods of a profile, from the Dependencies list of
+// each mod's meta.lsx. Building, ordering and cycle detection (Tarjan's
+// strongly connected components) are all linear in the number of mods plus
+// dependencies.
+class ModDependencyGraph {
+public:
+    struct Mod {
+        QString job;  // mod folder or pak, as scheduled
+        QVector<ModuleMeta> modules;
+    };
+
+    struct Missing {
+        QString uuid;
+        QString name;
+    };
+
+    void build(const QVector<Mod> &mods);
+    int size() const;
+    // Dependencies first; the mods of a cycle are kept together in list order.
+    QStringList order() const;
+    // Mods that are part of a dependency cycle.
+    QStringList cyclic() const;
+    // Jobs each job has to wait for. Edges within a cycle are dropped, so the
+    // result is always acyclic.
+    QHash<QString, QStringList> dependencies() const;
+    QVector<Missing> missing(const QString &job) const;
+
+private:
+    QStringList jobs;
+    QHash<QString, int> job_index;
+    QVector<QVector<int>> edges;  // job -> jobs it depends on
+    QVector<QVector<Missing>> missing_dependencies;
+    QStringList sorted;
+    QVector<bool> in_cycle;
+    QVector<int> component;  // strongly connected component of each job
+};
+
+#endif
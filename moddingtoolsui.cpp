@@ -10,21 +10,52 @@
 #include <QStyle>
 #include <QListWidget>
 #include <QSettings>
+#include <QPlainTextEdit>
+#include <QJsonDocument>
+#include <QScrollBar>
+#include <QLocale>
+#include <QPointer>
 
 ModdingToolsUI::ModdingToolsUI(QWidget *parent) : QMainWindow(parent) {
     setWindowTitle("Defakof's Modding Tools");
     setGeometry(100, 100, 1200, 800);
 
+    // Created before the scanner so it is destroyed (and waited on) first
+    memoryPool = new QThreadPool(this);
+    memoryPool->setMaxThreadCount(1);
+    lookupPool = new QThreadPool(this);
+    lookupPool->setMaxThreadCount(1);
+    translationRequest = 0;
+    deploying = false;
+
     pakScanner = new PakScanner(this);
     connect(pakScanner, &PakScanner::progress_updated, this, &ModdingToolsUI::updateStatus);
     connect(pakScanner, &PakScanner::divine_not_found, this, &ModdingToolsUI::onDivineNotFound);
     connect(pakScanner, &PakScanner::divine_download_progress, this, &ModdingToolsUI::handleDivineDownloadProgress);
     connect(pakScanner, &PakScanner::divine_download_finished, this, &ModdingToolsUI::handleDivineDownloadFinished);
+    connect(pakScanner, &PakScanner::scan_finished, this, &ModdingToolsUI::onScanFinished);
 
     downloadProgressDialog = nullptr;
+    metricsLabel = nullptr;
+    scanButton = nullptr;
+    pauseButton = nullptr;
+    stopButton = nullptr;
+
+    // Re-prioritize visible mods once scrolling settles instead of on every step
+    visibleModsTimer = new QTimer(this);
+    visibleModsTimer->setSingleShot(true);
+    visibleModsTimer->setInterval(150);
+    connect(visibleModsTimer, &QTimer::timeout, this, &ModdingToolsUI::updateVisibleMods);
+
+    // MO2 rewrites modlist.txt whenever the user reorders mods
+    modListWatcher = new QFileSystemWatcher(this);
+    connect(modListWatcher, &QFileSystemWatcher::fileChanged, this, &ModdingToolsUI::onModListChanged);
 
     loadSettings();
     createInitialUI();
+
+    // Warm the Divine version cache so the download flow never waits on the network
+    pakScanner->refresh_divine_version();
 }
 
 
@@ -67,12 +98,28 @@ void ModdingToolsUI::handleDivineDownloadFinished() {
         delete downloadProgressDialog;
         downloadProgressDialog = nullptr;
     }
+
+    // Pin the profile to the tool version it was set up with
+    if (!profileName.isEmpty() && !pakScanner->current_divine_version().isEmpty()) {
+        QSettings settings("DefakofModdingTools", "ModOrganizer");
+        settings.setValue("DivineVersion/" + profileName, pakScanner->current_divine_version());
+    }
     QMessageBox::information(this, "Download Complete", "Divine.exe has been downloaded and extracted successfully.");
 }
 
 void ModdingToolsUI::loadSettings() {
     QSettings settings("DefakofModdingTools", "ModOrganizer");
     moExePath = settings.value("MOExePath", "").toString();
+    pakScanner->set_prefer_tmpfs(settings.value("PreferTmpfs", false).toBool());
+    pakScanner->set_divine_sha256(settings.value("DivineSha256").toString().toLatin1());
+    if (settings.contains("DivineReleaseUrl")) {
+        pakScanner->set_release_url(settings.value("DivineReleaseUrl").toString());
+    }
+    // Stored values are game folder names; anything else falls back to the system locale
+    targetLanguage = settings.value("TargetLanguage").toString();
+    if (!TranslationDeployer::game_languages().contains(targetLanguage)) {
+        targetLanguage = TranslationDeployer::game_language(QLocale::system());
+    }
 }
 
 void ModdingToolsUI::saveSettings() {
@@ -154,7 +201,14 @@ void ModdingToolsUI::loadMainUI() {
         return;
     }
 
-    profilePath = QFileInfo(moExePath).absolutePath() + "/profiles/" + profileComboBox->currentText();
+    profileName = profileComboBox->currentText();
+    profilePath = QFileInfo(moExePath).absolutePath() + "/profiles/" + profileName;
+
+    QSettings settings("DefakofModdingTools", "ModOrganizer");
+    QString pinnedVersion = settings.value("DivineVersion/" + profileName).toString();
+    if (!pinnedVersion.isEmpty() && !pakScanner->use_divine_version(pinnedVersion)) {
+        updateStatus("Pinned Divine version " + pinnedVersion + " is not in the tool cache");
+    }
 
     // Clear the current central widget
     QWidget *oldCentralWidget = centralWidget();
@@ -164,6 +218,11 @@ void ModdingToolsUI::loadMainUI() {
     // Create and set the new main UI
     createMainUI();
     loadModList();
+
+    if (!modListWatcher->files().isEmpty()) {
+        modListWatcher->removePaths(modListWatcher->files());
+    }
+    modListWatcher->addPath(profilePath + "/modlist.txt");
 }
 
 void ModdingToolsUI::createMainUI() {
@@ -193,16 +252,37 @@ void ModdingToolsUI::createMainUI() {
     // Category 2
     QGroupBox *category2 = new QGroupBox(this);
     QHBoxLayout *category2Layout = new QHBoxLayout(category2);
-    QPushButton* scanButton = new QPushButton("Scan", this);
+    scanButton = new QPushButton("Scan", this);
     connect(scanButton, &QPushButton::clicked, this, &ModdingToolsUI::onScanButtonClicked);
     category2Layout->addWidget(scanButton);
-    category2Layout->addWidget(new QPushButton("Deploy", this));
+    pauseButton = new QPushButton("Pause", this);
+    pauseButton->setEnabled(false);
+    connect(pauseButton, &QPushButton::clicked, this, &ModdingToolsUI::onPauseButtonClicked);
+    category2Layout->addWidget(pauseButton);
+    stopButton = new QPushButton("Stop", this);
+    stopButton->setEnabled(false);
+    connect(stopButton, &QPushButton::clicked, this, &ModdingToolsUI::onStopButtonClicked);
+    category2Layout->addWidget(stopButton);
+    QPushButton *deployButton = new QPushButton("Deploy", this);
+    connect(deployButton, &QPushButton::clicked, this, &ModdingToolsUI::onDeployButtonClicked);
+    category2Layout->addWidget(deployButton);
+    languageComboBox = new QComboBox(this);
+    languageComboBox->setToolTip("Language to translate into");
+    languageComboBox->addItems(TranslationDeployer::game_languages().mid(1));
+    languageComboBox->setPlaceholderText("Target language");
+    languageComboBox->setCurrentIndex(languageComboBox->findText(targetLanguage));
+    connect(languageComboBox, &QComboBox::currentTextChanged, this, &ModdingToolsUI::onLanguageChanged);
+    category2Layout->addWidget(languageComboBox);
     buttonsLayout->addWidget(category2);
 
     // Category 3
     QGroupBox *category3 = new QGroupBox(this);
     QHBoxLayout *category3Layout = new QHBoxLayout(category3);
     category3Layout->addWidget(new QPushButton("Sort", this));
+    QPushButton *vanillaButton = new QPushButton("Vanilla", this);
+    vanillaButton->setToolTip("Index the game's own localization");
+    connect(vanillaButton, &QPushButton::clicked, this, &ModdingToolsUI::onVanillaButtonClicked);
+    category3Layout->addWidget(vanillaButton);
     buttonsLayout->addWidget(category3);
 
     topBar->addWidget(buttonsContainer, 1);
@@ -284,6 +364,17 @@ void ModdingToolsUI::createMainUI() {
     statusLabel = new QLabel("Ready", this);
     statusBar()->addPermanentWidget(statusLabel);
 
+    // Diagnostics panel for the last scan
+    metricsLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(metricsLabel);
+    QPushButton *diagnosticsButton = new QPushButton("Diagnostics", this);
+    connect(diagnosticsButton, &QPushButton::clicked, this, &ModdingToolsUI::showDiagnostics);
+    statusBar()->addPermanentWidget(diagnosticsButton);
+    QPushButton *scanLogButton = new QPushButton("Scan Log", this);
+    connect(scanLogButton, &QPushButton::clicked, this, &ModdingToolsUI::showScanLog);
+    statusBar()->addPermanentWidget(scanLogButton);
+    updateMetricsLabel();
+
     setupConnections();
 }
 
@@ -293,6 +384,37 @@ void ModdingToolsUI::onScanButtonClicked() {
 
 void ModdingToolsUI::setupConnections() {
     connect(modTree, &QTreeWidget::itemClicked, this, &ModdingToolsUI::onItemClicked);
+    connect(modTree->verticalScrollBar(), &QScrollBar::valueChanged, visibleModsTimer, qOverload<>(&QTimer::start));
+    connect(modTree, &QTreeWidget::itemExpanded, visibleModsTimer, qOverload<>(&QTimer::start));
+    connect(modTree, &QTreeWidget::itemCollapsed, visibleModsTimer, qOverload<>(&QTimer::start));
+}
+
+QString ModdingToolsUI::modsDirectory() const {
+    return QFileInfo(moExePath).absolutePath() + "/mods";
+}
+
+QStringList ModdingToolsUI::visibleModDirs() const {
+    QStringList modDirs;
+    QString modsDir = modsDirectory();
+    int viewportHeight = modTree->viewport()->height();
+    QTreeWidgetItem *item = modTree->itemAt(0, 0);
+    while (item) {
+        QRect rect = modTree->visualItemRect(item);
+        if (rect.top() >= viewportHeight) {
+            break;
+        }
+        if (!item->data(0, Qt::UserRole).toBool()) { // If it's not a separator
+            modDirs << modsDir + "/" + item->text(0);
+        }
+        item = modTree->itemBelow(item);
+    }
+    return modDirs;
+}
+
+void ModdingToolsUI::updateVisibleMods() {
+    if (pakScanner->is_scanning()) {
+        pakScanner->set_visible_mods(visibleModDirs());
+    }
 }
 
 void ModdingToolsUI::loadModList() {
@@ -305,6 +427,7 @@ void ModdingToolsUI::loadModList() {
 
     QTextStream in(&file);
     modTree->clear();
+    modOrder.clear();
     int modCount = 0;
 
     // Add the four main separators
@@ -339,6 +462,7 @@ void ModdingToolsUI::loadModList() {
 
                 // Add all mods to the "Recently Added" category by default
                 recentlyAdded->addChild(item);
+                modOrder << modName;
                 modCount++;
             }
         }
@@ -346,10 +470,298 @@ void ModdingToolsUI::loadModList() {
     file.close();
 
     pluginLabel->setText("Plugins: " + QString::number(modCount));
+    applyScanResults();
+}
+
+void ModdingToolsUI::applyScanResults() {
+    QHash<QString, ModSummary> summaries;
+    for (const ModSummary &summary : pakScanner->scan_database().mod_summaries()) {
+        summaries.insert(QDir::cleanPath(summary.path), summary);
+    }
+
+    QHash<QString, QVector<ModuleMeta>> modules;
+    for (const ModModule &module : pakScanner->scan_database().mod_modules()) {
+        modules[QDir::cleanPath(module.mod_path)] << module.meta;
+    }
+
+    // Translation state straight from the mapped snapshot, one pass for all mods
+    QHash<QString, QByteArrayList> fingerprints = pakScanner->scan_database().pak_fingerprints();
+    QSharedPointer<const LocaSnapshot> snapshot = pakScanner->localization_snapshot();
+    QHash<QByteArray, LocaSnapshot::Coverage> coverage;
+    if (targetLanguage != "English") {
+        coverage = snapshot->coverage("English", targetLanguage);
+    }
+
+    // Strings that replace a base game line, one lookup each in the vanilla table
+    const VanillaBaseline &vanilla = pakScanner->vanilla_baseline();
+    QHash<QByteArray, int> vanillaOverrides;
+    if (vanilla.is_open()) {
+        vanillaOverrides = snapshot->count_by_source("English", [&vanilla](QByteArrayView key, QByteArrayView) {
+            return vanilla.contains("English", key);
+        });
+    }
+
+    QTreeWidgetItem* translated = nullptr;
+    QTreeWidgetItem* requireTranslation = nullptr;
+    for (int i = 0; i < modTree->topLevelItemCount(); ++i) {
+        QTreeWidgetItem* separator = modTree->topLevelItem(i);
+        if (separator->text(0) == "Translated") {
+            translated = separator;
+        } else if (separator->text(0) == "Require Translation") {
+            requireTranslation = separator;
+        }
+    }
+
+    QList<QTreeWidgetItem*> mods;
+    QTreeWidgetItemIterator it(modTree);
+    while (*it) {
+        if (!(*it)->data(0, Qt::UserRole).toBool()) {
+            mods << *it;
+        }
+        ++it;
+    }
+
+    QString modsDir = modsDirectory();
+    QVector<ModDependencyGraph::Mod> graphMods;
+    for (QTreeWidgetItem* item : mods) {
+        QString modDir = QDir::cleanPath(modsDir + "/" + item->text(0));
+        graphMods << ModDependencyGraph::Mod{modDir, modules.value(modDir)};
+    }
+    ModDependencyGraph dependencies;
+    dependencies.build(graphMods);
+    QStringList cyclicMods = dependencies.cyclic();
+    QSet<QString> cyclic(cyclicMods.begin(), cyclicMods.end());
+
+    QHash<QString, QSet<QByteArray>> modSources;
+    for (QTreeWidgetItem* item : mods) {
+        QString modDir = QDir::cleanPath(modsDir + "/" + item->text(0));
+        for (const QByteArray &fingerprint : fingerprints.value(modDir)) {
+            modSources[item->text(0)].insert(fingerprint);
+        }
+        QVector<ModDependencyGraph::Missing> missing = dependencies.missing(modDir);
+        item->setIcon(0, missing.isEmpty() ? QIcon() : style()->standardIcon(QStyle::SP_MessageBoxWarning));
+        auto summary = summaries.constFind(modDir);
+        if (summary == summaries.constEnd()) {
+            item->setData(0, Qt::UserRole + 1, "Not scanned yet");
+            continue;
+        }
+
+        QString languages = summary->languages.isEmpty() ? "none" : summary->languages.join(", ");
+        QString toolTip = QString("PAK files: %1\nLanguages: %2\nStrings: %3\nMCM: %4")
+                              .arg(summary->paks)
+                              .arg(languages)
+                              .arg(summary->strings)
+                              .arg(summary->has_mcm ? "yes" : "no");
+        for (const ModuleMeta &module : modules.value(modDir)) {
+            toolTip += QString("\nModule: %1 %2").arg(module.name, module.version);
+        }
+        for (const ModDependencyGraph::Missing &dependency : missing) {
+            toolTip += "\nMissing dependency: " + (dependency.name.isEmpty() ? dependency.uuid : dependency.name);
+        }
+        if (cyclic.contains(modDir)) {
+            toolTip += "\nPart of a dependency cycle";
+        }
+
+        LocaSnapshot::Coverage modCoverage;
+        int overrides = 0;
+        for (const QByteArray &fingerprint : fingerprints.value(modDir)) {
+            LocaSnapshot::Coverage pakCoverage = coverage.value(fingerprint);
+            modCoverage.total += pakCoverage.total;
+            modCoverage.translated += pakCoverage.translated;
+            overrides += vanillaOverrides.value(fingerprint);
+        }
+        if (overrides > 0) {
+            toolTip += QString("\nOverrides %1 vanilla strings").arg(overrides);
+        }
+        if (modCoverage.total > 0) {
+            toolTip += QString("\n%1: %2/%3 strings").arg(targetLanguage).arg(modCoverage.translated).arg(modCoverage.total);
+            QTreeWidgetItem* category = modCoverage.translated == modCoverage.total ? translated : requireTranslation;
+            if (category && item->parent() != category) {
+                item->parent()->removeChild(item);
+                category->addChild(item);
+            }
+        }
+        item->setData(0, Qt::UserRole + 1, toolTip);
+    }
+
+    conflicts.build(*snapshot, targetLanguage, modSources, modOrder);
+    updateConflictToolTips();
+
+    rebuildTranslationMemory();
+}
+
+QStringList ModdingToolsUI::readModOrder() const {
+    QStringList order;
+    QFile file(profilePath + "/modlist.txt");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return order;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.startsWith("+")) {
+            QString modName = line.mid(1).trimmed();
+            if (!modName.endsWith("_separator")) {
+                order << modName;
+            }
+        }
+    }
+    return order;
+}
+
+void ModdingToolsUI::updateConflictToolTips() {
+    QTreeWidgetItemIterator it(modTree);
+    while (*it) {
+        QTreeWidgetItem* item = *it;
+        ++it;
+        if (item->data(0, Qt::UserRole).toBool()) {
+            continue;
+        }
+
+        QString toolTip = item->data(0, Qt::UserRole + 1).toString();
+        ConflictAnalyzer::ModStats stats = conflicts.stats(item->text(0));
+        if (stats.overrides > 0) {
+            toolTip += QString("\nOverrides %1 strings of lower mods").arg(stats.overrides);
+        }
+        if (stats.shadowed > 0) {
+            toolTip += QString("\nShadowed translations: %1").arg(stats.shadowed);
+            QVector<ConflictAnalyzer::Conflict> shadowed = conflicts.shadowed(item->text(0), 5);
+            for (const ConflictAnalyzer::Conflict &conflict : shadowed) {
+                toolTip += QString("\n    %1 (by %2)").arg(QString::fromUtf8(conflict.key)).arg(conflict.winner);
+            }
+        }
+        item->setToolTip(0, toolTip);
+    }
+}
+
+void ModdingToolsUI::onModListChanged() {
+    // Saving through a rename drops the file from the watcher
+    QString modlistPath = profilePath + "/modlist.txt";
+    if (!modListWatcher->files().contains(modlistPath) && QFile::exists(modlistPath)) {
+        modListWatcher->addPath(modlistPath);
+    }
+
+    QStringList order = readModOrder();
+    if (order.isEmpty() || order == modOrder) {
+        return;
+    }
+    modOrder = order;
+    int recomputed = conflicts.set_order(order);
+    updateConflictToolTips();
+    updateStatus(QString("Load order changed, %1 conflicting strings re-evaluated").arg(recomputed));
+}
+
+void ModdingToolsUI::rebuildTranslationMemory() {
+    if (targetLanguage == "English") {
+        return;
+    }
+
+    // Building the index over every scanned pair takes a while, keep it off the UI thread
+    QPointer<ModdingToolsUI> self(this);
+    QSharedPointer<const LocaSnapshot> snapshot = pakScanner->localization_snapshot();
+    QString language = targetLanguage;
+    memoryPool->start([self, snapshot, language]() {
+        QSharedPointer<TranslationMemory> memory(new TranslationMemory);
+        memory->build(*snapshot, "English", language);
+        QSharedPointer<DuplicateStrings> duplicates(new DuplicateStrings);
+        duplicates->build(snapshot, "English");
+        QMetaObject::invokeMethod(self, [self, memory, duplicates]() {
+            if (!self) {
+                return;
+            }
+            self->translationMemory = memory;
+            self->duplicateStrings = duplicates;
+            if (self->translationCount) {
+                self->translationCount->setText(QString("Translations: %1, unique source strings: %2 of %3 (%4%)")
+                                                    .arg(memory->size())
+                                                    .arg(duplicates->unique())
+                                                    .arg(duplicates->total())
+                                                    .arg(duplicates->unique_ratio() * 100.0, 0, 'f', 1));
+            }
+            if (!self->selectedModDir.isEmpty()) {
+                self->showModTranslations(self->selectedModDir);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ModdingToolsUI::showModTranslations(const QString &modDir) {
+    selectedModDir = modDir;
+    translationList->clear();
+    int request = ++translationRequest;
+    if (targetLanguage == "English") {
+        return;
+    }
+
+    QSet<QByteArray> sources;
+    for (const QByteArray &fingerprint : pakScanner->scan_database().pak_fingerprints().value(QDir::cleanPath(modDir))) {
+        sources.insert(fingerprint);
+    }
+
+    // Untranslated strings of the mod, each with the closest existing translation.
+    // Fuzzy lookups take a while, so the rows are built on the lookup pool and
+    // only shown if no other mod was selected meanwhile.
+    QPointer<ModdingToolsUI> self(this);
+    QSharedPointer<const LocaSnapshot> snapshot = pakScanner->localization_snapshot();
+    QSharedPointer<TranslationMemory> memory = translationMemory;
+    QSharedPointer<DuplicateStrings> duplicates = duplicateStrings;
+    QString language = targetLanguage;
+    lookupPool->start([self, request, snapshot, memory, duplicates, sources, language]() {
+        const int maxShown = 200;
+        QVector<QPair<QString, QByteArray>> rows;
+        for (const auto &string : snapshot->strings("English", sources)) {
+            QString existing;
+            if (snapshot->lookup(language, string.key, existing)) {
+                continue;
+            }
+
+            QString text = string.text;
+            QString propagated;
+            if (duplicates && duplicates->snapshot() == snapshot) {
+                // An identical line already translated elsewhere can be reused as is
+                int index = snapshot->index_of("English", string.key);
+                for (int duplicate : duplicates->duplicates_of(index)) {
+                    QByteArray duplicateKey;
+                    if (snapshot->entry("English", duplicate, &duplicateKey, nullptr) && snapshot->lookup(language, duplicateKey, propagated)
+                        && duplicates->same_text(index, duplicate)) {
+                        break;
+                    }
+                    propagated.clear();
+                }
+            }
+            if (!propagated.isEmpty()) {
+                text += QString("\n    = %1 (identical string)").arg(propagated);
+            } else if (memory) {
+                QVector<TranslationMemory::Suggestion> suggestions = memory->lookup(string.text, 1);
+                if (!suggestions.isEmpty()) {
+                    text += QString("\n    -> %1 (%2%)").arg(suggestions.first().target).arg(int(suggestions.first().similarity * 100));
+                }
+            }
+            rows << qMakePair(text, string.key);
+            if (rows.size() == maxShown) {
+                break;
+            }
+        }
+
+        QMetaObject::invokeMethod(self, [self, request, rows]() {
+            if (!self || request != self->translationRequest) {
+                return;
+            }
+            for (const auto &row : rows) {
+                QListWidgetItem *item = new QListWidgetItem(row.first, self->translationList);
+                item->setData(Qt::UserRole, row.second);
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 void ModdingToolsUI::scanMods() {
-    QString modsDir = QFileInfo(moExePath).absolutePath() + "/mods";
+    if (deploying) {
+        QMessageBox::warning(this, "Scan", "Wait for the deploy to finish before scanning.");
+        return;
+    }
+    QString modsDir = modsDirectory();
     QDir dir(modsDir);
     if (!dir.exists()) {
         QMessageBox::critical(this, "Error", "Mods folder not found");
@@ -360,6 +772,7 @@ void ModdingToolsUI::scanMods() {
         return;  // Stop if divine is not found
     }
 
+    QStringList modDirs;
     QTreeWidgetItemIterator it(modTree);
     while (*it) {
         QTreeWidgetItem* item = *it;
@@ -367,22 +780,229 @@ void ModdingToolsUI::scanMods() {
             QString modName = item->text(0);
             QString modDir = modsDir + "/" + modName;
             if (QDir(modDir).exists()) {
-                pakScanner->scan_mod_folder(modDir, "Mod Organizer 2");
+                modDirs << modDir;
+            }
+        }
+        ++it;
+    }
+
+    bool resume = false;
+    if (pakScanner->has_checkpoint()) {
+        resume = QMessageBox::question(this, "Resume Scan",
+                                       "A previous scan was interrupted. Continue where it stopped?",
+                                       QMessageBox::Yes|QMessageBox::No) == QMessageBox::Yes;
+    }
+
+    pakScanner->scan_mods(modDirs, "Mod Organizer 2", resume);
+    if (pakScanner->is_scanning()) {
+        scanButton->setEnabled(false);
+        pauseButton->setEnabled(true);
+        pauseButton->setText("Pause");
+        stopButton->setEnabled(true);
+        updateVisibleMods();
+    }
+}
+
+void ModdingToolsUI::onScanFinished(bool completed) {
+    if (scanButton) {
+        scanButton->setEnabled(true);
+        pauseButton->setEnabled(false);
+        pauseButton->setText("Pause");
+        stopButton->setEnabled(false);
+    }
+    if (!completed) {
+        updateStatus("Scan stopped, it can be resumed with Scan");
+    }
+    updateMetricsLabel();
+    if (scanButton) {
+        applyScanResults();
+    }
+}
+
+void ModdingToolsUI::onLanguageChanged(const QString &language) {
+    if (language.isEmpty() || language == targetLanguage) {
+        return;
+    }
+    targetLanguage = language;
+    QSettings settings("DefakofModdingTools", "ModOrganizer");
+    settings.setValue("TargetLanguage", targetLanguage);
+
+    // Coverage, conflicts and the translation memory all depend on the language
+    translationMemory.reset();
+    applyScanResults();
+    if (!selectedModDir.isEmpty()) {
+        showModTranslations(selectedModDir);
+    }
+}
+
+void ModdingToolsUI::onDeployButtonClicked() {
+    if (targetLanguage == "English" || !duplicateStrings) {
+        QMessageBox::information(this, "Deploy", "Scan the profile first to collect translations.");
+        return;
+    }
+    if (pakScanner->is_scanning()) {
+        QMessageBox::warning(this, "Deploy", "Wait for the scan to finish before deploying.");
+        return;
+    }
+    if (deploying) {
+        return;
+    }
+    // Entry indexes of the duplicate groups are only valid in the snapshot they were built from
+    QSharedPointer<const LocaSnapshot> snapshot = duplicateStrings->snapshot();
+    if (snapshot != pakScanner->localization_snapshot()) {
+        QMessageBox::information(this, "Deploy", "Translations of the last scan are still being indexed, try again in a moment.");
+        return;
+    }
+
+    QString modsDir = modsDirectory();
+    QHash<QString, QByteArrayList> fingerprints = pakScanner->scan_database().pak_fingerprints();
+    QVector<TranslationDeployer::ModInput> mods;
+    QTreeWidgetItemIterator it(modTree);
+    while (*it) {
+        QTreeWidgetItem* item = *it;
+        if (!item->data(0, Qt::UserRole).toBool()) {
+            TranslationDeployer::ModInput mod;
+            mod.name = item->text(0);
+            for (const QByteArray &fingerprint : fingerprints.value(QDir::cleanPath(modsDir + "/" + mod.name))) {
+                mod.sources.insert(fingerprint);
+            }
+            if (!mod.sources.isEmpty()) {
+                mods << mod;
             }
         }
         ++it;
     }
+
+    QString language = targetLanguage;
+    QString packagePath = modsDir + "/DMT Translation " + language + "/DMT_Translation_" + language + ".pak";
+    updateStatus("Deploying " + language + " translations...");
+
+    // Scans wait for the deploy, the snapshot it reads stays pinned either way
+    deploying = true;
+    scanButton->setEnabled(false);
+    QPointer<ModdingToolsUI> self(this);
+    QSharedPointer<DuplicateStrings> duplicates = duplicateStrings;
+    memoryPool->start([self, snapshot, duplicates, mods, language, packagePath]() {
+        TranslationDeployer deployer(*snapshot, *duplicates, "English", language);
+        TranslationDeployer::Result result;
+        QString error;
+        bool deployed = deployer.deploy(mods, packagePath, result, error);
+        QMetaObject::invokeMethod(self, [self, deployed, result, error, packagePath]() {
+            if (!self) {
+                return;
+            }
+            self->deploying = false;
+            self->scanButton->setEnabled(!self->pakScanner->is_scanning());
+            if (deployed && result.unchanged) {
+                self->updateStatus("Translations are up to date in " + packagePath);
+            } else if (deployed) {
+                self->updateStatus(QString("Deployed %1 strings for %2 mods to %3 (%4 files reused)")
+                                       .arg(result.strings).arg(result.files).arg(packagePath).arg(result.reused));
+            } else {
+                self->updateStatus("Deploy failed: " + error);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ModdingToolsUI::onVanillaButtonClicked() {
+    QSettings settings("DefakofModdingTools", "ModOrganizer");
+    QString dataDir = QFileDialog::getExistingDirectory(this, "Select the game's Data folder", settings.value("GameDataPath").toString());
+    if (dataDir.isEmpty()) {
+        return;
+    }
+    settings.setValue("GameDataPath", dataDir);
+
+    QPointer<ModdingToolsUI> self(this);
+    PakScanner *scanner = pakScanner;
+    memoryPool->start([self, scanner, dataDir]() {
+        QString error;
+        scanner->build_vanilla_baseline(dataDir, error);
+        QMetaObject::invokeMethod(self, [self]() {
+            if (self && self->scanButton) {
+                self->applyScanResults();
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ModdingToolsUI::onPauseButtonClicked() {
+    if (pauseButton->text() == "Pause") {
+        pakScanner->pause_scan();
+        pauseButton->setText("Resume");
+    } else {
+        pakScanner->resume_scan();
+        pauseButton->setText("Pause");
+    }
+}
+
+void ModdingToolsUI::onStopButtonClicked() {
+    pakScanner->cancel_scan();
+    stopButton->setEnabled(false);
+}
+
+void ModdingToolsUI::updateMetricsLabel() {
+    if (!metricsLabel) {
+        return;
+    }
+
+    const ScanMetrics &metrics = pakScanner->scan_metrics();
+    const ProgressAggregator *progress = pakScanner->scan_progress();
+    metricsLabel->setText(QString("Paks: %1 | Read: %2 MB | Cache hits: %3% | Divine runs: %4 | Events: %5 | Errors: %6")
+                              .arg(metrics.value(ScanMetrics::PaksScanned))
+                              .arg(metrics.value(ScanMetrics::BytesRead) / (1024 * 1024))
+                              .arg(metrics.cache_hit_ratio() * 100.0, 0, 'f', 0)
+                              .arg(metrics.value(ScanMetrics::DivineLaunches))
+                              .arg(progress->event_count())
+                              .arg(progress->error_count()));
+}
+
+void ModdingToolsUI::showDiagnostics() {
+    const ScanMetrics &metrics = pakScanner->scan_metrics();
+    QString text = metrics.summary() + "\n";
+    if (duplicateStrings) {
+        text += duplicateStrings->report() + "\n";
+    }
+    showTextDialog("Scan Diagnostics", text + QJsonDocument(metrics.to_json()).toJson(QJsonDocument::Indented));
+}
+
+void ModdingToolsUI::showScanLog() {
+    showTextDialog("Scan Log", pakScanner->scan_progress()->full_log().join("\n"));
+}
+
+void ModdingToolsUI::showTextDialog(const QString &title, const QString &text) {
+    QDialog dialog(this);
+    dialog.setWindowTitle(title);
+    dialog.resize(600, 400);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    QPlainTextEdit *details = new QPlainTextEdit(&dialog);
+    details->setReadOnly(true);
+    details->setPlainText(text);
+    layout->addWidget(details);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    dialog.exec();
 }
 
 void ModdingToolsUI::onItemClicked(QTreeWidgetItem *item, int column) {
     if (item->data(0, Qt::UserRole).toBool()) { // If it's a separator
         item->setExpanded(!item->isExpanded());
+    } else {
+        if (pakScanner->is_scanning()) {
+            // Scan the mod the user is looking at next
+            pakScanner->prioritize_mods(QStringList() << modsDirectory() + "/" + item->text(0), ScanScheduler::Selected);
+        }
+        showModTranslations(modsDirectory() + "/" + item->text(0));
     }
 }
 
 void ModdingToolsUI::updateStatus(const QString &message) {
     statusLabel->setText(message);
-    // Update other UI elements as needed
+    statusLabel->setToolTip(pakScanner->scan_progress()->recent_events(20).join("\n"));
 }
 
 void ModItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
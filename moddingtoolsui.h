@@ -20,6 +20,14 @@
 #include <QComboBox>
 #include <QStyledItemDelegate>
 #include "pakscanner.h"
+#include "translationmemory.h"
+#include "duplicatestrings.h"
+#include "translationdeployer.h"
+#include "conflictanalyzer.h"
+#include "moddependencygraph.h"
+#include <QFileSystemWatcher>
+#include <QSharedPointer>
+#include <QThreadPool>
 #include <QListWidget>
 #include <QMessageBox>
 #include <QProgressDialog>
@@ -44,6 +52,9 @@ private:
     void setupConnections();
     void selectModOrganizerExe();
     void loadModList();
+    void applyScanResults();
+    QStringList readModOrder() const;
+    void updateConflictToolTips();
     void scanMods();
     void loadSettings();
     void saveSettings();
@@ -53,25 +64,59 @@ private:
     void handleDivineNotFound();
     void handleDivineDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
     void handleDivineDownloadFinished();
+    void updateMetricsLabel();
+    QString modsDirectory() const;
+    QStringList visibleModDirs() const;
+    void showTextDialog(const QString &title, const QString &text);
+    void rebuildTranslationMemory();
+    void showModTranslations(const QString &modDir);
 
     PakScanner *pakScanner;
     QString moExePath;
     QString profilePath;
+    QString profileName;
+    QString targetLanguage;
     QTreeWidget *modTree;
     QListWidget *translationList;
     QLabel *statusLabel;
+    QLabel *metricsLabel;
     QLabel *pluginLabel;
     QLabel *translationCount;
     QLabel *downloadCount;
     QLabel *moPathLabel;
     QComboBox *profileComboBox;
+    QComboBox *languageComboBox;
     QProgressDialog *downloadProgressDialog;
+    QPushButton *scanButton;
+    QPushButton *pauseButton;
+    QPushButton *stopButton;
+    QTimer *visibleModsTimer;
+    QThreadPool *memoryPool;
+    QThreadPool *lookupPool;
+    int translationRequest;
+    bool deploying;
+    QSharedPointer<TranslationMemory> translationMemory;
+    QSharedPointer<DuplicateStrings> duplicateStrings;
+    QString selectedModDir;
+    QStringList modOrder;
+    ConflictAnalyzer conflicts;
+    QFileSystemWatcher *modListWatcher;
 
     private slots:
         void updateStatus(const QString &message);
         void onDivineNotFound();
     void onItemClicked(QTreeWidgetItem *item, int column);
     void onScanButtonClicked();
+    void onScanFinished(bool completed);
+    void onPauseButtonClicked();
+    void onStopButtonClicked();
+    void onDeployButtonClicked();
+    void onLanguageChanged(const QString &language);
+    void onVanillaButtonClicked();
+    void onModListChanged();
+    void updateVisibleMods();
+    void showDiagnostics();
+    void showScanLog();
 };
 
 #endif
\ No newline at end of file
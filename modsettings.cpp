@@ -0,0 +1,369 @@
+#include "modsettings.h"
+#include "lspkreader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QSet>
+#include <cstring>
+
+namespace {
+
+// One tag of the file. Only the attributes LSX nodes use are kept.
+struct Tag {
+    QByteArrayView name;
+    QByteArrayView id;
+    QByteArrayView value;
+    bool closing = false;
+    bool self_closing = false;
+};
+
+bool same(QByteArrayView view, const char *text) {
+    size_t length = strlen(text);
+    return size_t(view.size()) == length && memcmp(view.data(), text, length) == 0;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Reads the tag starting at p (just past '<') and leaves p past its '>'.
+bool read_tag(const char *&p, const char *end, Tag &tag) {
+    tag = Tag();
+    if (p < end && *p == '/') {
+        tag.closing = true;
+        ++p;
+    }
+    const char *name = p;
+    while (p < end && !is_space(*p) && *p != '>' && *p != '/') {
+        ++p;
+    }
+    tag.name = QByteArrayView(name, p - name);
+
+    while (p < end) {
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        if (p == end) {
+            return false;
+        }
+        if (*p == '>') {
+            ++p;
+            return true;
+        }
+        if (*p == '/') {
+            tag.self_closing = true;
+            ++p;
+            continue;
+        }
+
+        const char *attribute = p;
+        while (p < end && *p != '=' && *p != '>' && !is_space(*p)) {
+            ++p;
+        }
+        QByteArrayView attribute_name(attribute, p - attribute);
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        if (p == end || *p != '=') {
+            continue;
+        }
+        ++p;
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        if (p == end || (*p != '"' && *p != '\'')) {
+            return false;
+        }
+        char quote = *p++;
+        const char *value = p;
+        while (p < end && *p != quote) {
+            ++p;
+        }
+        if (p == end) {
+            return false;
+        }
+        QByteArrayView attribute_value(value, p - value);
+        ++p;
+
+        if (same(attribute_name, "id")) {
+            tag.id = attribute_value;
+        } else if (same(attribute_name, "value")) {
+            tag.value = attribute_value;
+        }
+    }
+    return false;
+}
+
+// Attribute values only ever contain the predefined entities and character references
+QString unescape(QByteArrayView view) {
+    if (!memchr(view.data(), '&', size_t(view.size()))) {
+        return QString::fromUtf8(view);
+    }
+
+    QByteArray value = view.toByteArray();
+    QByteArray text;
+    text.reserve(value.size());
+    for (qsizetype i = 0; i < value.size(); ++i) {
+        if (value[i] != '&') {
+            text += value[i];
+            continue;
+        }
+        qsizetype semicolon = value.indexOf(';', i);
+        if (semicolon < 0) {
+            text += value.mid(i);
+            break;
+        }
+        QByteArray entity = value.mid(i + 1, semicolon - i - 1);
+        if (entity == "amp") {
+            text += '&';
+        } else if (entity == "lt") {
+            text += '<';
+        } else if (entity == "gt") {
+            text += '>';
+        } else if (entity == "quot") {
+            text += '"';
+        } else if (entity == "apos") {
+            text += '\'';
+        } else if (entity.startsWith('#')) {
+            bool ok = false;
+            uint code = entity.startsWith("#x") ? entity.mid(2).toUInt(&ok, 16) : entity.mid(1).toUInt(&ok, 10);
+            if (ok) {
+                char32_t character = char32_t(code);
+                text += QString::fromUcs4(&character, 1).toUtf8();
+            }
+        } else {
+            text += value.mid(i, semicolon - i + 1);
+        }
+        i = semicolon;
+    }
+    return QString::fromUtf8(text);
+}
+
+}
+
+bool ModSettings::read(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Unable to open " + path + ": " + file.errorString();
+        module_list.clear();
+        return false;
+    }
+
+    qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (data) {
+        return parse(QByteArrayView(reinterpret_cast<const char *>(data), size));
+    }
+    return parse(file.readAll());
+}
+
+bool ModSettings::parse(QByteArrayView data) {
+    module_list.clear();
+    error.clear();
+
+    QVector<Module> described;
+    QStringList order;
+    QVector<QByteArrayView> nodes;  // ids of the open nodes
+    Module module;
+    bool in_mod_order = false;
+
+    const char *p = data.data();
+    const char *end = p + data.size();
+    while (true) {
+        p = static_cast<const char *>(memchr(p, '<', size_t(end - p)));
+        if (!p) {
+            break;
+        }
+        ++p;
+        if (p < end && (*p == '?' || *p == '!')) {
+            // Declaration or comment, neither can contain a node
+            bool comment = end - p > 2 && p[1] == '-' && p[2] == '-';
+            const char *close = p;
+            while ((close = static_cast<const char *>(memchr(close, '>', size_t(end - close))))) {
+                if (!comment || (close - p >= 4 && close[-1] == '-' && close[-2] == '-')) {
+                    break;
+                }
+                ++close;
+            }
+            if (!close) {
+                break;
+            }
+            p = close + 1;
+            continue;
+        }
+
+        Tag tag;
+        if (!read_tag(p, end, tag)) {
+            error = "Truncated tag in modsettings.lsx";
+            return false;
+        }
+
+        if (same(tag.name, "node")) {
+            if (tag.closing) {
+                if (!nodes.isEmpty()) {
+                    QByteArrayView closed = nodes.takeLast();
+                    if (same(closed, "ModuleShortDesc")) {
+                        described << module;
+                    } else if (same(closed, "ModOrder")) {
+                        in_mod_order = false;
+                    }
+                }
+                continue;
+            }
+            if (same(tag.id, "ModuleShortDesc")) {
+                module = Module();
+            } else if (same(tag.id, "ModOrder")) {
+                in_mod_order = true;
+            }
+            if (tag.self_closing) {
+                if (same(tag.id, "ModuleShortDesc")) {
+                    described << module;
+                }
+                continue;
+            }
+            nodes << tag.id;
+        } else if (same(tag.name, "attribute") && !nodes.isEmpty()) {
+            QByteArrayView node = nodes.last();
+            if (same(node, "ModuleShortDesc")) {
+                if (same(tag.id, "UUID")) {
+                    module.uuid = unescape(tag.value);
+                } else if (same(tag.id, "Folder")) {
+                    module.folder = unescape(tag.value);
+                } else if (same(tag.id, "Name")) {
+                    module.name = unescape(tag.value);
+                } else if (same(tag.id, "Version64")) {
+                    module.version = version_string(unescape(tag.value).toULongLong());
+                } else if (same(tag.id, "Version") && module.version.isEmpty()) {
+                    module.version = version_string(unescape(tag.value).toUInt(), false);
+                }
+            } else if (in_mod_order && same(node, "Module") && same(tag.id, "UUID")) {
+                order << unescape(tag.value);
+            }
+        }
+    }
+
+    // Older game versions keep the order in a separate ModOrder list; newer
+    // ones drop it and the Mods list itself is the load order.
+    if (!order.isEmpty()) {
+        QHash<QString, int> by_uuid;
+        for (int i = 0; i < described.size(); ++i) {
+            by_uuid.insert(described[i].uuid, i);
+        }
+        QVector<Module> ordered;
+        for (const QString &uuid : order) {
+            auto it = by_uuid.constFind(uuid);
+            if (it != by_uuid.constEnd()) {
+                ordered << described[it.value()];
+            }
+        }
+        described = ordered;
+    }
+
+    for (const Module &entry : described) {
+        if (!is_builtin(entry)) {
+            module_list << entry;
+        }
+    }
+    return true;
+}
+
+QString ModSettings::error_string() const {
+    return error;
+}
+
+const QVector<ModSettings::Module> &ModSettings::modules() const {
+    return module_list;
+}
+
+QStringList ModSettings::resolve_paks(const QString &mods_dir, QStringList *missing) const {
+    QStringList paks;
+    QDir dir(mods_dir);
+    QStringList files = dir.entryList(QStringList() << "*.pak", QDir::Files, QDir::Name);
+
+    // Most paks are named after the module folder or its display name
+    QHash<QString, QString> by_base_name;
+    for (const QString &file : files) {
+        by_base_name.insert(QFileInfo(file).completeBaseName().toLower(), dir.filePath(file));
+    }
+
+    QVector<int> unresolved;
+    QVector<QString> resolved(module_list.size());
+    QSet<QString> used;
+    for (int i = 0; i < module_list.size(); ++i) {
+        QString pak = by_base_name.value(module_list[i].folder.toLower());
+        if (pak.isEmpty()) {
+            pak = by_base_name.value(module_list[i].name.toLower());
+        }
+        if (pak.isEmpty() || used.contains(pak)) {
+            unresolved << i;
+        } else {
+            resolved[i] = pak;
+            used.insert(pak);
+        }
+    }
+
+    // The rest are identified by the Mods/<Folder>/ entries in their file table
+    if (!unresolved.isEmpty()) {
+        QHash<QString, QString> by_folder;
+        QHash<QString, int> part_counts;
+        for (const QString &file : files) {
+            QString path = dir.filePath(file);
+            if (used.contains(path) || LspkReader::is_secondary_part(path, &part_counts)) {
+                continue;
+            }
+            LspkReader reader(path);
+            if (!reader.open()) {
+                continue;
+            }
+            for (const LspkReader::Entry &entry : reader.entries()) {
+                if (entry.name.startsWith("Mods/") && entry.name.endsWith("/meta.lsx")) {
+                    by_folder.insert(entry.name.mid(5, entry.name.size() - 5 - 9).toLower(), path);
+                }
+            }
+        }
+        for (int i : unresolved) {
+            QString pak = by_folder.value(module_list[i].folder.toLower());
+            if (!pak.isEmpty() && !used.contains(pak)) {
+                resolved[i] = pak;
+                used.insert(pak);
+            }
+        }
+    }
+
+    for (int i = 0; i < module_list.size(); ++i) {
+        if (!resolved[i].isEmpty()) {
+            paks << resolved[i];
+        } else if (missing) {
+            *missing << module_list[i].folder;
+        }
+    }
+    return paks;
+}
+
+bool ModSettings::is_builtin_uuid(const QString &uuid) {
+    // GustavDev, Gustav, GustavX, Shared, SharedDev and Honour
+    static const QStringList builtin_uuids = {
+        "28ac9ce2-2aba-8cda-b3b5-6e922f71b6b8", "991c9c7a-fb80-40cb-8f0d-b92d4e80e9b1",
+        "cb555efe-2d9e-131f-8195-a89329d218ea", "ed539163-bb70-431b-96a7-f5b2eda5376b",
+        "3d0c5ff8-c95d-c907-ff3e-34b204f1c630", "b77b6210-ac50-4cb1-a3d5-5702fb9c744c"
+    };
+    return builtin_uuids.contains(uuid, Qt::CaseInsensitive);
+}
+
+QString ModSettings::version_string(quint64 version, bool packed64) {
+    if (packed64) {
+        return QString("%1.%2.%3.%4").arg(version >> 55).arg((version >> 47) & 0xff).arg((version >> 31) & 0xffff).arg(version & 0x7fffffff);
+    }
+    return QString("%1.%2.%3.%4").arg(version >> 28).arg((version >> 24) & 0xf).arg((version >> 16) & 0xff).arg(version & 0xffff);
+}
+
+QString ModSettings::default_path(const QString &mods_dir) {
+    return QDir::cleanPath(mods_dir + "/../PlayerProfiles/Public/modsettings.lsx");
+}
+
+bool ModSettings::is_builtin(const Module &module) {
+    // The base game and its story modules are always listed first
+    static const QStringList builtin_folders = {"GustavDev", "GustavX", "Gustav", "Shared", "SharedDev", "Honour", "MainUI", "ModBrowser"};
+    return builtin_folders.contains(module.folder, Qt::CaseInsensitive);
+}
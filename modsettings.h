@@ -0,0 +1,47 @@
+#ifndef MODSETTINGS_H
+#define MODSETTINGS_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
+
+// Load order of the game's own mod list, as written by BG3 Mod Manager into
+// PlayerProfiles/Public/modsettings.lsx. Only ModuleShortDesc nodes (and the
+// ModOrder list of older game versions) matter, so the file is read with a
+// single forward pass over its tags instead of building a DOM.
+class ModSettings {
+public:
+    struct Module {
+        QString uuid;
+        QString folder;
+        QString name;
+        QString version;
+    };
+
+    bool read(const QString &path);
+    bool parse(QByteArrayView data);
+    QString error_string() const;
+    // Active modules in load order, base game modules excluded.
+    const QVector<Module> &modules() const;
+
+    // Pak files under mods_dir for the active modules, in load order. Folders
+    // of modules without a pak are added to missing.
+    QStringList resolve_paks(const QString &mods_dir, QStringList *missing = nullptr) const;
+
+    // modsettings.lsx that belongs to a Mods folder of the game's user data.
+    static QString default_path(const QString &mods_dir);
+    static bool is_builtin(const Module &module);
+    // Same check for a dependency that is only known by its UUID.
+    static bool is_builtin_uuid(const QString &uuid);
+    // major.minor.revision.build from a Version64 value, or from the 32-bit
+    // Version attribute of older files.
+    static QString version_string(quint64 version, bool packed64 = true);
+
+private:
+    QVector<Module> module_list;
+    QString error;
+};
+
+#endif
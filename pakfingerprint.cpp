@@ -0,0 +1,92 @@
+#include "pakfingerprint.h"
+#include <QFile>
+#include <QCryptographicHash>
+#include <QtEndian>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// LSPK v15+ header: magic, version, file list offset (u64), file list size (u32), ...
+static const int header_size = 40;
+// Upper bound for the file table read, anything larger falls back to sampling.
+static const qint64 max_file_table_size = 16 * 1024 * 1024;
+static const qint64 sample_size = 64 * 1024;
+
+QByteArray PakFingerprint::compute(const QString &pak_file, qint64 *bytes_read) {
+    QFile file(pak_file);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    qint64 size = file.size();
+    qint64 read = 0;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(size));
+
+    QByteArray header = file.read(header_size);
+    read += header.size();
+    hash.addData(header);
+
+    bool hashed_table = false;
+    if (header.size() == header_size && header.startsWith("LSPK")) {
+        quint64 table_offset = qFromLittleEndian<quint64>(header.constData() + 8);
+        quint32 table_size = qFromLittleEndian<quint32>(header.constData() + 16);
+        if (table_size <= max_file_table_size && table_offset + table_size <= quint64(size) && file.seek(qint64(table_offset))) {
+            QByteArray table = file.read(table_size);
+            read += table.size();
+            hash.addData(table);
+            hashed_table = table.size() == qint64(table_size);
+        }
+    }
+
+    if (!hashed_table) {
+        // Older or unknown layouts keep their table elsewhere; sample both ends instead.
+        file.seek(0);
+        QByteArray head = file.read(sample_size);
+        file.seek(qMax<qint64>(0, size - sample_size));
+        QByteArray tail = file.read(sample_size);
+        read += head.size() + tail.size();
+        hash.addData(head);
+        hash.addData(tail);
+    }
+
+    if (bytes_read) {
+        *bytes_read = read;
+    }
+    return hash.result().toHex();
+}
+
+QByteArray PakFingerprint::file_id(const QString &path) {
+    quint64 volume = 0;
+    quint64 index = 0;
+#ifdef Q_OS_WIN
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t *>(path.utf16()), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return QByteArray();
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    bool queried = GetFileInformationByHandle(handle, &info);
+    CloseHandle(handle);
+    if (!queried) {
+        return QByteArray();
+    }
+    volume = info.dwVolumeSerialNumber;
+    index = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+#else
+    struct stat info;
+    if (stat(QFile::encodeName(path).constData(), &info) != 0) {
+        return QByteArray();
+    }
+    volume = quint64(info.st_dev);
+    index = quint64(info.st_ino);
+#endif
+
+    QByteArray id(16, '\0');
+    qToLittleEndian<quint64>(volume, id.data());
+    qToLittleEndian<quint64>(index, id.data() + 8);
+    return id;
+}
@@ -0,0 +1,20 @@
+#ifndef PAKFINGERPRINT_H
+#define PAKFINGERPRINT_H
+
+#include <QByteArray>
+#include <QString>
+
+// Cheap content identity for a .pak: file size, the LSPK header and the raw
+// (still compressed) file table. Two paks with the same fingerprint list the
+// same entries at the same offsets, so their scan results are interchangeable.
+class PakFingerprint {
+public:
+    // Returns an empty array if the file cannot be read. bytes_read, if given,
+    // receives the number of bytes actually read from disk.
+    static QByteArray compute(const QString &pak_file, qint64 *bytes_read = nullptr);
+    // Identity of the file itself (volume and inode or file index), shared by
+    // all hardlinks to it. Empty if the file cannot be queried.
+    static QByteArray file_id(const QString &path);
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "pakresultcache.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QMutexLocker>
+
+// Results written before module metadata was read would hide it forever
+static const int cache_version = 2;
+
+QJsonObject ModuleMeta::to_json() const {
+    QJsonObject json;
+    json["uuid"] = uuid;
+    json["folder"] = folder;
+    json["name"] = name;
+    json["version"] = version;
+    json["dependencies"] = QJsonArray::fromStringList(dependencies);
+    json["dependency_names"] = QJsonArray::fromStringList(dependency_names);
+    return json;
+}
+
+ModuleMeta ModuleMeta::from_json(const QJsonObject &json) {
+    ModuleMeta meta;
+    meta.uuid = json["uuid"].toString();
+    meta.folder = json["folder"].toString();
+    meta.name = json["name"].toString();
+    meta.version = json["version"].toString();
+    for (const QJsonValue &value : json["dependencies"].toArray()) {
+        meta.dependencies << value.toString();
+    }
+    for (const QJsonValue &value : json["dependency_names"].toArray()) {
+        meta.dependency_names << value.toString();
+    }
+    return meta;
+}
+
+QJsonObject PakScanResult::to_json() const {
+    QJsonObject json;
+    json["languages"] = QJsonArray::fromStringList(languages);
+    json["mcm_mods"] = QJsonArray::fromStringList(mcm_mods);
+    QJsonObject counts;
+    for (auto it = string_counts.constBegin(); it != string_counts.constEnd(); ++it) {
+        counts[it.key()] = it.value();
+    }
+    json["string_counts"] = counts;
+    QJsonArray module_list;
+    for (const ModuleMeta &module : modules) {
+        module_list.append(module.to_json());
+    }
+    json["modules"] = module_list;
+    return json;
+}
+
+PakScanResult PakScanResult::from_json(const QJsonObject &json) {
+    PakScanResult result;
+    for (const QJsonValue &value : json["languages"].toArray()) {
+        result.languages << value.toString();
+    }
+    for (const QJsonValue &value : json["mcm_mods"].toArray()) {
+        result.mcm_mods << value.toString();
+    }
+    QJsonObject counts = json["string_counts"].toObject();
+    for (auto it = counts.begin(); it != counts.end(); ++it) {
+        result.string_counts.insert(it.key(), it.value().toInt());
+    }
+    for (const QJsonValue &value : json["modules"].toArray()) {
+        result.modules << ModuleMeta::from_json(value.toObject());
+    }
+    return result;
+}
+
+PakResultCache::PakResultCache() : dirty(false) {
+}
+
+void PakResultCache::set_path(const QString &path) {
+    QMutexLocker locker(&mutex);
+    file_path = path;
+}
+
+bool PakResultCache::load() {
+    QMutexLocker locker(&mutex);
+    results.clear();
+    dirty = false;
+
+    QFile file(file_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["version"].toInt() != cache_version) {
+        return false;
+    }
+    QJsonObject paks = root["paks"].toObject();
+    for (auto it = paks.begin(); it != paks.end(); ++it) {
+        results.insert(it.key().toLatin1(), PakScanResult::from_json(it.value().toObject()));
+    }
+    return true;
+}
+
+bool PakResultCache::save() {
+    QMutexLocker locker(&mutex);
+    if (!dirty) {
+        return true;
+    }
+
+    QJsonObject paks;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        paks[QString::fromLatin1(it.key())] = it.value().to_json();
+    }
+
+    QJsonObject root;
+    root["version"] = cache_version;
+    root["paks"] = paks;
+
+    QSaveFile file(file_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+bool PakResultCache::lookup(const QByteArray &fingerprint, PakScanResult &result) const {
+    QMutexLocker locker(&mutex);
+    auto it = results.constFind(fingerprint);
+    if (it == results.constEnd()) {
+        return false;
+    }
+    result = it.value();
+    return true;
+}
+
+void PakResultCache::insert(const QByteArray &fingerprint, const PakScanResult &result) {
+    QMutexLocker locker(&mutex);
+    results.insert(fingerprint, result);
+    dirty = true;
+}
+
+int PakResultCache::size() const {
+    QMutexLocker locker(&mutex);
+    return results.size();
+}
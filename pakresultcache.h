@@ -0,0 +1,56 @@
+#ifndef PAKRESULTCACHE_H
+#define PAKRESULTCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QJsonObject>
+
+// Identity of a mod as declared by its Mods/<Folder>/meta.lsx.
+struct ModuleMeta {
+    QString uuid;
+    QString folder;
+    QString name;
+    QString version;
+    QStringList dependencies;  // UUIDs
+    QStringList dependency_names;  // same order, for display
+
+    QJsonObject to_json() const;
+    static ModuleMeta from_json(const QJsonObject &json);
+};
+
+// What a scan learned about one pak.
+struct PakScanResult {
+    QStringList languages;
+    QStringList mcm_mods;
+    QHash<QString, int> string_counts;  // per language
+    QVector<ModuleMeta> modules;
+
+    QJsonObject to_json() const;
+    static PakScanResult from_json(const QJsonObject &json);
+};
+
+// Scan results keyed by pak fingerprint, kept across runs so duplicate paks
+// (in this scan or a previous one) are only processed once.
+class PakResultCache {
+public:
+    PakResultCache();
+    void set_path(const QString &path);
+    bool load();
+    bool save();
+
+    bool lookup(const QByteArray &fingerprint, PakScanResult &result) const;
+    void insert(const QByteArray &fingerprint, const PakScanResult &result);
+    int size() const;
+
+private:
+    QString file_path;
+    mutable QMutex mutex;
+    QHash<QByteArray, PakScanResult> results;
+    bool dirty;
+};
+
+#endif
@@ -3,18 +3,79 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QCoreApplication>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDateTime>
 
 PakScanner::PakScanner(QObject *parent) : QObject(parent) {
     divine_path = QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/divine.exe";
-    temp_path = QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/temp";
+    temp_path = default_temp_path();
     retain_temp_files = false;
+    release_url = "https://github.com/Norbyte/lslib/releases/download";
+    download_pending = false;
     network_manager = new QNetworkAccessManager(this);
     timer = new QTimer(this);
     timer->setSingleShot(true);
+    progress = new ProgressAggregator(this);
+    progress->set_log_path(QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/scan_log.txt");
+    connect(progress, &ProgressAggregator::progress_updated, this, &PakScanner::progress_updated);
+    version_resolver = new DivineVersionResolver(network_manager, QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/divine_tags.json", this);
+    connect(version_resolver, &DivineVersionResolver::version_resolved, this, &PakScanner::on_divine_version_resolved);
+    connect(version_resolver, &DivineVersionResolver::resolve_failed, this, &PakScanner::on_divine_version_failed);
+    temp_cleaner = new TempCleaner(this);
+    connect(temp_cleaner, &TempCleaner::cleanup_finished, this, [this](const QString &dir, qint64 files_removed, bool success) {
+        if (success) {
+            report_progress(QString("Cleaned up %1 temporary files").arg(files_removed));
+        } else {
+            report_error("Error cleaning up temporary files in " + dir);
+        }
+    });
+    temp_cleaner->sweep(QFileInfo(temp_path).absolutePath());
+    scan_pool = new QThreadPool(this);
+    scan_pool->setMaxThreadCount(QThread::idealThreadCount());
+    checkpoint.set_path(QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/scan_checkpoint.json");
+    result_cache.set_path(QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/pak_results.json");
+    resumed_scan = false;
+    snapshot_path = QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/loca_snapshot.bin";
+    open_latest_snapshot();
+    vanilla_path = QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/vanilla_baseline.bin";
+    vanilla.open(vanilla_path);
+    if (!database.open(QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/scan_results.db")) {
+        qWarning() << "Unable to open scan result database:" << database.error_string();
+    }
+
+    // Fall back to the newest cached ExportTool when there is no local divine.exe
+    if (!check_divine_exists()) {
+        QStringList versions = tool_cache.installed_versions();
+        if (!versions.isEmpty()) {
+            use_divine_version(versions.first());
+        }
+    }
+}
+
+PakScanner::~PakScanner() {
+    control.cancel();
+    scan_pool->waitForDone();
+    database.close();
 }
 
 void PakScanner::set_divine_path(const QString &path) {
     divine_path = path;
+    divine_version.clear();
+}
+
+bool PakScanner::use_divine_version(const QString &version) {
+    QString path = tool_cache.divine_path(version);
+    if (path.isEmpty()) {
+        return false;
+    }
+    divine_path = path;
+    divine_version = version;
+    return true;
+}
+
+QString PakScanner::current_divine_version() const {
+    return divine_version;
 }
 
 bool PakScanner::check_divine_exists() {
@@ -23,155 +84,674 @@ bool PakScanner::check_divine_exists() {
 
 void PakScanner::set_temp_path(const QString &path) {
     temp_path = path;
+    temp_cleaner->sweep(QFileInfo(temp_path).absolutePath());
+}
+
+QString PakScanner::default_temp_path() {
+    return QFileInfo(QCoreApplication::applicationFilePath()).absolutePath() + "/temp";
+}
+
+void PakScanner::set_prefer_tmpfs(bool prefer) {
+    // Extraction output is small and short-lived, keep it in RAM when possible
+    QString tmpfs_root = prefer ? TempCleaner::tmpfs_root(512LL * 1024 * 1024) : QString();
+    set_temp_path(tmpfs_root.isEmpty() ? default_temp_path() : tmpfs_root + "/temp");
+}
+
+QString PakScanner::current_temp_path() const {
+    return temp_path;
 }
 
 void PakScanner::set_retain_temp_files(bool retain) {
     retain_temp_files = retain;
 }
 
-QString PakScanner::get_latest_divine_version() {
-    QString owner = "Norbyte";
-    QString project = "lslib";
-    QUrl url("https://api.github.com/repos/" + owner + "/" + project + "/tags");
-    qInfo() << "Fetching latest Divine version from:" << url.toString();
-
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-
-    QNetworkReply *reply = network_manager->get(request);
-
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-
-    // Set up a timer for timeout
-    QTimer timer;
-    timer.setSingleShot(true);
-    connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-    timer.start(5000);  // 5 second timeout
-
-    // Wait for either finished() or timeout
-    loop.exec();
-
-    if (timer.isActive()) {
-        // Request finished before timeout
-        timer.stop();
-        if (reply->error() == QNetworkReply::NoError) {
-            QByteArray response_data = reply->readAll();
-            QJsonDocument json = QJsonDocument::fromJson(response_data);
-            QJsonArray tags = json.array();
-            if (!tags.isEmpty()) {
-                QString version = tags[0].toObject()["name"].toString();
-                reply->deleteLater();
-                return version;
-            }
-        } else {
-            qWarning() << "Error fetching latest version:" << reply->errorString();
-        }
-    } else {
-        qWarning() << "Request timed out";
-    }
+void PakScanner::report_progress(const QString &message) {
+    progress->report(message);
+}
 
-    reply->deleteLater();
-    return QString("Timeout");
+void PakScanner::report_error(const QString &message) {
+    progress->report(message, ProgressAggregator::Error);
 }
 
 void PakScanner::download_divine() {
-    QString latest_version = get_latest_divine_version();
-    if (latest_version == "Timeout" || latest_version.isEmpty()) {
-        emit progress_updated("Failed to fetch the latest Divine version");
+    QString cached_version = version_resolver->cached_version();
+    if (!cached_version.isEmpty()) {
+        start_divine_download(cached_version);
+        version_resolver->refresh_if_stale();
         return;
     }
 
+    // Nothing cached yet, the download starts once the lookup answers
+    download_pending = true;
+    version_resolver->refresh();
+}
+
+void PakScanner::refresh_divine_version() {
+    version_resolver->refresh_if_stale();
+}
+
+void PakScanner::on_divine_version_resolved(const QString &version) {
+    if (download_pending) {
+        download_pending = false;
+        start_divine_download(version);
+    }
+}
+
+void PakScanner::on_divine_version_failed(const QString &error) {
+    if (download_pending) {
+        download_pending = false;
+        report_error("Failed to fetch the latest Divine version: " + error);
+    }
+}
+
+void PakScanner::start_divine_download(const QString &version) {
+    QString latest_version = version;
+
     // Remove 'v' prefix if present
     if (latest_version.startsWith('v')) {
         latest_version.remove(0, 1);
     }
 
-    QUrl url("https://github.com/Norbyte/lslib/releases/download/v" + latest_version + "/ExportTool-v" + latest_version + ".zip");
+    if (use_divine_version(latest_version)) {
+        report_progress("Using cached ExportTool v" + latest_version + ": " + divine_path);
+        emit divine_download_finished();
+        return;
+    }
+
+    QUrl url(release_url + "/v" + latest_version + "/ExportTool-v" + latest_version + ".zip");
     qInfo() << "Downloading Divine from:" << url.toString();
 
-    QNetworkRequest request(url);
-    QNetworkReply *reply = network_manager->get(request);
-
-    connect(reply, &QNetworkReply::downloadProgress, this, &PakScanner::divine_download_progress);
-    connect(reply, &QNetworkReply::finished, [this, reply, latest_version]() {
-        if (reply->error() == QNetworkReply::NoError) {
-            QString zip_path = temp_path + "/ExportTool-v" + latest_version + ".zip";
-            QFile file(zip_path);
-            if (file.open(QIODevice::WriteOnly)) {
-                file.write(reply->readAll());
-                file.close();
-                emit progress_updated("Downloaded ExportTool zip to: " + zip_path);
-                // Here you should add code to extract the zip file and set the divine_path
-                extract_divine_zip(zip_path, latest_version);
-            } else {
-                emit progress_updated("Error saving ExportTool zip file to: " + zip_path);
-            }
+    QString zip_path = tool_cache.download_path(latest_version);
+    StreamingDownload *download = new StreamingDownload(network_manager, url, zip_path, this);
+    // An explicitly configured digest wins over the one GitHub publishes
+    QByteArray expected_sha256 = divine_expected_sha256;
+    if (expected_sha256.isEmpty()) {
+        expected_sha256 = version_resolver->asset_sha256(latest_version, "ExportTool-v" + latest_version + ".zip");
+    }
+    if (expected_sha256.isEmpty()) {
+        report_progress("No published checksum for ExportTool v" + latest_version + ", the download is not verified");
+    }
+    download->set_expected_sha256(expected_sha256);
+    connect(download, &StreamingDownload::progress, this, &PakScanner::divine_download_progress);
+    connect(download, &StreamingDownload::finished, this, [this, download, zip_path, latest_version](bool success, const QString &error) {
+        if (success) {
+            report_progress("Downloaded ExportTool zip to: " + zip_path + " (sha256 " + QString::fromLatin1(download->sha256()) + ")");
+            install_divine(zip_path, latest_version, download->sha256());
         } else {
-            emit progress_updated("Error downloading ExportTool: " + reply->errorString());
+            report_error("Error downloading ExportTool: " + error);
         }
-        reply->deleteLater();
+        download->deleteLater();
     });
+    download->start();
 }
 
-void PakScanner::extract_divine_zip(const QString &zip_path, const QString &version) {
-    // Add code here to extract the zip file later xd
+void PakScanner::set_divine_sha256(const QByteArray &hex_digest) {
+    divine_expected_sha256 = hex_digest;
+}
 
-    divine_path = temp_path + "/ExportTool-v" + version + "/divine.exe";
+void PakScanner::set_release_url(const QString &url) {
+    release_url = url;
+}
 
-    if (QFile::exists(divine_path)) {
-        emit progress_updated("Divine extracted successfully to: " + divine_path);
-        emit divine_download_finished();
-    } else {
-        emit progress_updated("Failed to extract Divine executable");
+void PakScanner::install_divine(const QString &zip_path, const QString &version, const QByteArray &sha256) {
+    QString error;
+    QString installed = tool_cache.install(version, zip_path, sha256, error);
+    if (installed.isEmpty()) {
+        report_error("Failed to extract Divine executable: " + error);
+        return;
     }
-}
 
+    divine_path = installed;
+    divine_version = version;
+    report_progress("Divine extracted successfully to: " + divine_path);
+    emit divine_download_finished();
+}
 
 void PakScanner::scan_mod_folder(const QString &mod_folder, const QString &mod_manager) {
     if (!checkDivine()) {
         return;  // Stop the scanning process if Divine is not found
     }
 
-    emit progress_updated("Scanning mod folder: " + mod_folder);
+    report_progress("Scanning mod folder: " + mod_folder);
 
     QStringList pak_files;
-    if (mod_manager == "Mod Organizer 2" || mod_manager == "Vortex") {
+    if (mod_manager == "Mod Organizer 2") {
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageDiscover);
         pak_files = find_pak_files(mod_folder);
+    } else if (mod_manager == "Vortex") {
+        // Unmanaged paks in the deployment folder come in one at a time
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageDiscover);
+        pak_files = QFileInfo(mod_folder).isFile() ? QStringList(mod_folder) : find_pak_files(mod_folder);
     } else if (mod_manager == "BG3 Mod Manager") {
-        emit progress_updated("BG3 Mod Manager support not yet implemented");
-        return;
+        // scan_mods hands out single paks so they spread over the workers
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageDiscover);
+        pak_files = QFileInfo(mod_folder).isFile() ? QStringList(mod_folder) : load_order_pak_files(mod_folder);
     } else {
-        emit progress_updated("Unsupported mod manager: " + mod_manager);
+        report_error("Unsupported mod manager: " + mod_manager);
         return;
     }
 
     for (const QString &pak_file : pak_files) {
-        process_pak_file(pak_file);
+        if (!control.wait_while_paused()) {
+            return;
+        }
+        if (checkpoint.is_completed(pak_file)) {
+            report_progress("Skipping already scanned PAK file: " + pak_file);
+            continue;
+        }
+        if (mod_manager == "Vortex" && !claim_file(pak_file)) {
+            report_progress("Skipping hardlink of an already scanned PAK file: " + pak_file);
+            continue;
+        }
+        if (process_pak_file(mod_folder, pak_file)) {
+            checkpoint.mark_completed(pak_file);
+        } else {
+            QMutexLocker locker(&failed_paks_lock);
+            failed_paks << pak_file;
+        }
+    }
+}
+
+void PakScanner::scan_mods(const QStringList &mod_folders, const QString &mod_manager, bool resume) {
+    if (!scanning.testAndSetAcquire(0, 1)) {
+        report_error("A scan is already running");
+        return;
+    }
+    if (!checkDivine()) {
+        scanning.storeRelease(0);
+        return;
+    }
+
+    metrics.reset();
+    progress->reset();
+    control.reset();
+    if (resume) {
+        checkpoint.load();
+    } else {
+        checkpoint.clear();
+    }
+    result_cache.load();
+    snapshot_builder.clear();
+    resumed_scan = resume;
+    database.begin_scan();
+    {
+        QMutexLocker locker(&part_counts_lock);
+        part_counts.clear();
+    }
+
+    // BG3 Mod Manager has no per-mod folders, every active pak is a mod of its own
+    QStringList scan_items = mod_folders;
+    if (mod_manager == "BG3 Mod Manager") {
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageDiscover);
+        scan_items.clear();
+        for (const QString &mods_dir : mod_folders) {
+            scan_items << load_order_pak_files(mods_dir);
+        }
+    } else if (mod_manager == "Vortex") {
+        // Staging and deployment folders expand to the deployed mods
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageDiscover);
+        scan_items.clear();
+        for (const QString &folder : mod_folders) {
+            QString error;
+            scan_items << VortexDeployment::scan_items(folder, &error);
+            if (!error.isEmpty()) {
+                report_error("Error reading Vortex deployment: " + error);
+            }
+        }
+    }
+    {
+        QMutexLocker locker(&file_ids_lock);
+        scanned_file_ids.clear();
+    }
+    {
+        QMutexLocker locker(&failed_paks_lock);
+        failed_paks.clear();
+    }
+    scanned_mods = scan_items;
+
+    scheduler.reset(scan_items, scan_dependencies(scan_items));
+    int workers = qMax(1, qMin(scan_pool->maxThreadCount(), int(scan_items.size())));
+    scratch_pool.set_recycle(!retain_temp_files);
+    scratch_pool.reset(temp_path + "/scratch", workers);
+    active_workers.storeRelease(workers);
+    for (int i = 0; i < workers; ++i) {
+        scan_pool->start([this, mod_manager]() {
+            run_scan_worker(mod_manager);
+        });
+    }
+}
+
+void PakScanner::run_scan_worker(const QString &mod_manager) {
+    QString mod_folder;
+    while (control.wait_while_paused() && scheduler.take(mod_folder)) {
+        scan_mod_folder(mod_folder, mod_manager);
+        scheduler.finish(mod_folder);
+    }
+
+    if (active_workers.fetchAndSubOrdered(1) == 1) {
+        finish_scan();
+    }
+}
+
+QHash<QString, QStringList> PakScanner::scan_dependencies(const QStringList &jobs) {
+    // Dependencies come from the meta.lsx files of the previous scan; mods not
+    // scanned before are simply not held back.
+    QHash<QString, int> index;
+    QVector<ModDependencyGraph::Mod> mods;
+    for (const QString &job : jobs) {
+        if (!index.contains(job)) {
+            index.insert(job, int(mods.size()));
+            mods << ModDependencyGraph::Mod{job, {}};
+        }
+    }
+    for (const ModModule &module : database.mod_modules()) {
+        auto it = index.find(module.mod_path);
+        if (it != index.end()) {
+            mods[it.value()].modules << module.meta;
+        }
+    }
+
+    ModDependencyGraph graph;
+    graph.build(mods);
+    QStringList cyclic = graph.cyclic();
+    if (!cyclic.isEmpty()) {
+        QStringList names;
+        for (const QString &job : cyclic) {
+            names << QFileInfo(job).fileName();
+        }
+        report_progress("Dependency cycle between mods: " + names.join(", "));
+    }
+    return graph.dependencies();
+}
+
+void PakScanner::finish_scan() {
+    bool completed = !control.is_cancelled();
+    scheduler.clear();
+    result_cache.save();
+    // Paks that are gone from the scanned mods; paks that failed keep their
+    // previous results, and mods outside this scan are left alone.
+    bool prune = completed && !resumed_scan;
+    if (prune) {
+        QMutexLocker locker(&failed_paks_lock);
+        database.prune_unseen(scanned_mods, failed_paks);
+    }
+    database.flush();
+    write_snapshot(prune);
+    if (completed) {
+        checkpoint.clear();
+    } else {
+        checkpoint.save();
+        report_progress(QString("Scan cancelled, %1 PAK files checkpointed").arg(checkpoint.completed_count()));
+    }
+
+    cleanup_temp_files();
+    progress->flush();
+    scanning.storeRelease(0);
+    emit scan_finished(completed);
+}
+
+QString PakScanner::snapshot_file(quint64 generation) const {
+    // loca_snapshot.bin -> loca_snapshot.<generation>.bin
+    QFileInfo base(snapshot_path);
+    return base.absolutePath() + "/" + base.completeBaseName() + "." + QString::number(generation) + "." + base.suffix();
+}
+
+void PakScanner::open_latest_snapshot() {
+    // Superseded generations still on disk lost their readers with the last run
+    QFileInfo base(snapshot_path);
+    QDir dir(base.absolutePath());
+    QStringList files = dir.entryList({base.completeBaseName() + ".*." + base.suffix()}, QDir::Files);
+    snapshot_generation = 0;
+    for (const QString &file : files) {
+        snapshot_generation = qMax(snapshot_generation, file.section('.', -2, -2).toULongLong());
+    }
+    for (const QString &file : files) {
+        if (file.section('.', -2, -2).toULongLong() != snapshot_generation) {
+            dir.remove(file);
+        }
+    }
+
+    QSharedPointer<LocaSnapshot> latest = QSharedPointer<LocaSnapshot>::create();
+    if (snapshot_generation > 0) {
+        latest->open(snapshot_file(snapshot_generation));
+    }
+    QMutexLocker locker(&snapshot_lock);
+    snapshot = latest;
+}
+
+void PakScanner::write_snapshot(bool prune) {
+    // Paks skipped this time keep their strings from the previous snapshot.
+    // After pruning, sources no pak in the database refers to any more are
+    // dropped, so the snapshot follows the database's decision.
+    QSet<QByteArray> referenced;
+    if (prune) {
+        const QHash<QString, QByteArrayList> fingerprints = database.pak_fingerprints();
+        for (const QByteArrayList &mod_fingerprints : fingerprints) {
+            for (const QByteArray &fingerprint : mod_fingerprints) {
+                referenced.insert(fingerprint);
+            }
+        }
+    }
+    QSharedPointer<const LocaSnapshot> previous = localization_snapshot();
+    snapshot_builder.carry_over(*previous, prune, referenced);
+
+    // Readers may still hold the previous snapshot, so every generation gets
+    // a file of its own rather than replacing the mapped one.
+    QString path = snapshot_file(snapshot_generation + 1);
+    QString error;
+    bool written = snapshot_builder.write(path, error);
+    snapshot_builder.clear();
+    if (!written) {
+        report_error("Error writing localization snapshot: " + error);
+        return;
+    }
+    QSharedPointer<LocaSnapshot> fresh = QSharedPointer<LocaSnapshot>::create();
+    if (!fresh->open(path)) {
+        report_error("Error opening localization snapshot: " + path);
+        QFile::remove(path);
+        return;
+    }
+    snapshot_generation++;
+
+    // Publish on the thread that owns the scanner; the old file is deleted
+    // once the last reader lets go of it.
+    QMetaObject::invokeMethod(this, [this, fresh]() {
+        QMutexLocker locker(&snapshot_lock);
+        snapshot->discard_on_close();
+        snapshot = fresh;
+    }, Qt::QueuedConnection);
+}
+
+void PakScanner::prioritize_mods(const QStringList &mod_folders, ScanScheduler::Priority priority) {
+    scheduler.prioritize(mod_folders, priority);
+}
+
+void PakScanner::set_visible_mods(const QStringList &mod_folders) {
+    scheduler.set_visible(mod_folders);
+}
+
+bool PakScanner::is_scanning() const {
+    return scanning.loadAcquire() != 0;
+}
+
+bool PakScanner::has_checkpoint() {
+    return !is_scanning() && checkpoint.load() && checkpoint.completed_count() > 0;
+}
+
+void PakScanner::cancel_scan() {
+    control.cancel();
+    scheduler.clear();  // Wakes workers waiting on dependencies
+}
+
+void PakScanner::pause_scan() {
+    control.pause();
+    report_progress("Scan paused");
+}
+
+void PakScanner::resume_scan() {
+    control.resume();
+    report_progress("Scan resumed");
+}
+
+const ScanMetrics &PakScanner::scan_metrics() const {
+    return metrics;
+}
+
+const ProgressAggregator *PakScanner::scan_progress() const {
+    return progress;
+}
+
+ScanDatabase &PakScanner::scan_database() {
+    return database;
+}
+
+QSharedPointer<const LocaSnapshot> PakScanner::localization_snapshot() const {
+    QMutexLocker locker(&snapshot_lock);
+    return snapshot;
+}
+
+const VanillaBaseline &PakScanner::vanilla_baseline() const {
+    return vanilla;
+}
+
+bool PakScanner::build_vanilla_baseline(const QString &data_dir, QString &error) {
+    report_progress("Indexing vanilla localization in " + data_dir);
+    // The old table has to be unmapped before it can be replaced
+    vanilla.close();
+    int strings = 0;
+    bool built = VanillaBaseline::build(data_dir, vanilla_path, error, &strings);
+    vanilla.open(vanilla_path);
+    if (built) {
+        report_progress(QString("Indexed %1 vanilla strings in %2 languages").arg(strings).arg(vanilla.languages().size()));
+    } else {
+        report_error("Error indexing vanilla localization: " + error);
     }
+    return built;
+}
+
+QStringList PakScanner::load_order_pak_files(const QString &mods_dir) {
+    ModSettings settings;
+    QString settings_path = ModSettings::default_path(mods_dir);
+    if (!settings.read(settings_path)) {
+        report_error("Error reading load order: " + settings.error_string());
+        return QStringList();
+    }
+
+    QStringList missing;
+    QStringList pak_files = settings.resolve_paks(mods_dir, &missing);
+    report_progress(QString("Load order from %1: %2 active mods").arg(settings_path).arg(settings.modules().size()));
+    for (const QString &folder : missing) {
+        report_progress("No PAK file found for active mod: " + folder);
+    }
+    return pak_files;
 }
 
 QStringList PakScanner::find_pak_files(const QString &folder) {
     QStringList pak_files;
     QDirIterator it(folder, QStringList() << "*.pak", QDir::Files, QDirIterator::Subdirectories);
     while (it.hasNext()) {
-        pak_files << it.next();
+        QString pak_file = it.next();
+        if (!is_secondary_part(pak_file)) {
+            pak_files << pak_file;
+        }
     }
     return pak_files;
 }
 
-void PakScanner::process_pak_file(const QString &pak_file) {
-    emit progress_updated("Processing PAK file: " + pak_file);
+bool PakScanner::claim_file(const QString &pak_file) {
+    // Vortex deploys hardlinks, so staging and game folder can hold the same file
+    QByteArray id = PakFingerprint::file_id(pak_file);
+    if (id.isEmpty()) {
+        return true;
+    }
+    QMutexLocker locker(&file_ids_lock);
+    if (scanned_file_ids.contains(id)) {
+        return false;
+    }
+    scanned_file_ids.insert(id);
+    return true;
+}
+
+bool PakScanner::is_secondary_part(const QString &pak_file) {
+    // Only the main package's header is read, once per scan
+    qint64 bytes_read = 0;
+    bool secondary;
+    {
+        QMutexLocker locker(&part_counts_lock);
+        secondary = LspkReader::is_secondary_part(pak_file, &part_counts, &bytes_read);
+    }
+    metrics.add(ScanMetrics::BytesRead, bytes_read);
+    return secondary;
+}
+
+bool PakScanner::process_pak_file(const QString &mod_folder, const QString &pak_file) {
+    report_progress("Processing PAK file: " + pak_file);
+    QElapsedTimer pak_timer;
+    pak_timer.start();
+    metrics.add(ScanMetrics::PaksScanned);
+
+    qint64 fingerprint_bytes = 0;
+    QByteArray fingerprint = PakFingerprint::compute(pak_file, &fingerprint_bytes);
+    metrics.add(ScanMetrics::BytesRead, fingerprint_bytes);
+
+    // A cached result is only reusable if the strings behind it are in a snapshot too
+    PakScanResult result;
+    if (!fingerprint.isEmpty() && result_cache.lookup(fingerprint, result)
+        && (result.languages.isEmpty() || localization_snapshot()->has_source(fingerprint) || snapshot_builder.has_source(fingerprint))) {
+        metrics.add(ScanMetrics::IndexCacheHits);
+        snapshot_builder.mark_seen(fingerprint);
+        report_progress("Reusing results of an identical PAK file for: " + pak_file);
+        report_result(result);
+        record_pak(mod_folder, pak_file, fingerprint, result, pak_timer.nsecsElapsed() / 1000, true);
+        return true;
+    }
+    metrics.add(ScanMetrics::IndexCacheMisses);
+    result = PakScanResult();
+
+    QStringList folders = relevant_folders(pak_file, result);
+    if (folders.isEmpty()) {
+        // Pure asset pak, nothing worth extracting
+        report_progress("No localization or MCM data in " + pak_file);
+        if (!fingerprint.isEmpty()) {
+            result_cache.insert(fingerprint, result);
+        }
+        record_pak(mod_folder, pak_file, fingerprint, result, pak_timer.nsecsElapsed() / 1000, false);
+        return true;
+    }
+
+    ScratchPool::Lease scratch(scratch_pool, scratch_pool.acquire());
+    QString extract_dir = scratch.path();
+
+    {
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageExtract);
+        if (!extract_pak(pak_file, extract_dir, folders)) {
+            return false;
+        }
+    }
+    record_extracted_files(extract_dir);
+
+    ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageParse);
+    process_extracted_files(extract_dir, fingerprint, result);
+    if (control.is_cancelled()) {
+        return false;
+    }
+
+    if (!fingerprint.isEmpty()) {
+        result_cache.insert(fingerprint, result);
+    }
+    record_pak(mod_folder, pak_file, fingerprint, result, pak_timer.nsecsElapsed() / 1000, false);
+    return true;
+}
+
+void PakScanner::record_pak(const QString &mod_folder, const QString &pak_file, const QByteArray &fingerprint,
+                            const PakScanResult &result, qint64 scan_usec, bool from_cache) {
+    QFileInfo info(pak_file);
+    PakRecord record;
+    QFileInfo mod_info(mod_folder);
+    record.mod_name = mod_info.isFile() ? mod_info.completeBaseName() : mod_info.fileName();
+    record.mod_path = mod_folder;
+    record.pak_path = pak_file;
+    record.size = info.size();
+    record.modified = info.lastModified().toMSecsSinceEpoch();
+    record.fingerprint = fingerprint;
+    record.result = result;
+    record.scan_usec = scan_usec;
+    record.from_cache = from_cache;
+    database.record(record);
+}
+
+QStringList PakScanner::relevant_folders(const QString &pak_file, PakScanResult &result) {
+    ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageIndex);
+
+    LspkReader reader(pak_file);
+    bool opened = reader.open();
+    if (!opened) {
+        metrics.add(ScanMetrics::BytesRead, reader.bytes_read());
+        metrics.add(ScanMetrics::BytesMapped, reader.bytes_mapped());
+        // Unknown layout, let divine look at everything we care about
+        return QStringList() << "Localization" << "Mods";
+    }
+
+    bool has_localization = false;
+    bool has_mcm_blueprint = false;
+    for (const LspkReader::Entry &entry : reader.entries()) {
+        if (entry.name.startsWith("Localization/")) {
+            has_localization = true;
+        } else if (entry.name.startsWith("Mods/") && entry.name.endsWith("/MCM_blueprint.json")) {
+            has_mcm_blueprint = true;
+        } else if (entry.name.startsWith("Mods/") && entry.name.endsWith("/meta.lsx") && entry.name.count('/') == 2) {
+            // Small enough to read straight from the package, even for asset paks
+            LsResource meta;
+            ModuleMeta module;
+            QByteArray data = reader.read_entry(entry);
+            metrics.add(ScanMetrics::EntriesDecompressed);
+            if (!data.isNull() && meta.parse(data) && read_module_meta(meta, module)) {
+                result.modules << module;
+            }
+        }
+    }
+    metrics.add(ScanMetrics::BytesRead, reader.bytes_read());
+    metrics.add(ScanMetrics::BytesMapped, reader.bytes_mapped());
+
+    QStringList folders;
+    if (has_localization) {
+        folders << "Localization";
+    }
+    if (has_mcm_blueprint) {
+        folders << "Mods";
+    }
+    return folders;
+}
 
-    QString extract_dir = temp_path + "/" + QFileInfo(pak_file).fileName() + "_extracted";
-    QDir().mkpath(extract_dir);
+bool PakScanner::read_module_meta(const LsResource &meta, ModuleMeta &module) {
+    int info = meta.find("Config/root/ModuleInfo");
+    if (info < 0) {
+        return false;
+    }
+    module.uuid = meta.string(info, "UUID");
+    module.folder = meta.string(info, "Folder");
+    module.name = meta.string(info, "Name");
+    QByteArrayView version = meta.value(info, "Version64");
+    module.version = !version.isEmpty() ? ModSettings::version_string(version.toByteArray().toULongLong())
+                                        : ModSettings::version_string(meta.value(info, "Version").toByteArray().toUInt(), false);
+
+    int dependencies = meta.find("Config/root/Dependencies");
+    for (int index = dependencies < 0 ? -1 : meta.node(dependencies).first_child; index >= 0; index = meta.node(index).next_sibling) {
+        QString uuid = meta.string(index, "UUID");
+        if (!uuid.isEmpty()) {
+            QString name = meta.string(index, "Name");
+            module.dependencies << uuid;
+            module.dependency_names << (name.isEmpty() ? meta.string(index, "Folder") : name);
+        }
+    }
+    return !module.uuid.isEmpty();
+}
+
+void PakScanner::report_result(const PakScanResult &result) {
+    for (const QString &language : result.languages) {
+        report_progress("Found localization for language: " + language);
+    }
+    for (const QString &mod : result.mcm_mods) {
+        report_progress("Found MCM_blueprint.json in " + mod);
+    }
+}
 
-    extract_pak(pak_file, extract_dir, QStringList() << "Localization" << "Mods");
-    process_extracted_files(extract_dir);
+void PakScanner::record_extracted_files(const QString &extract_dir) {
+    QDirIterator it(extract_dir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        metrics.add(ScanMetrics::EntriesDecompressed);
+        metrics.add(ScanMetrics::TempBytesWritten, it.fileInfo().size());
+    }
 }
 
-void PakScanner::extract_pak(const QString &pak_file, const QString &extract_dir, const QStringList &folders_to_extract) {
+bool PakScanner::extract_pak(const QString &pak_file, const QString &extract_dir, const QStringList &folders_to_extract) {
+    bool extracted = true;
     for (const QString &folder : folders_to_extract) {
+        if (control.is_cancelled()) {
+            return false;
+        }
+
         QStringList args;
         args << "-g" << "bg3"
              << "-s" << pak_file
@@ -181,15 +761,29 @@ void PakScanner::extract_pak(const QString &pak_file, const QString &extract_dir
              << "-l" << "info";
 
         QProcess process;
+        metrics.add(ScanMetrics::DivineLaunches);
         process.start(divine_path, args);
-        process.waitForFinished(-1);
+
+        // Poll so a cancelled scan does not have to wait for divine to finish.
+        while (!process.waitForFinished(100)) {
+            if (process.state() == QProcess::NotRunning) {
+                break;
+            }
+            if (control.is_cancelled()) {
+                process.kill();
+                process.waitForFinished();
+                return false;
+            }
+        }
 
         if (process.exitCode() == 0) {
-            emit progress_updated("Extracted " + folder + " from " + pak_file + " to " + extract_dir);
+            report_progress("Extracted " + folder + " from " + pak_file + " to " + extract_dir);
         } else {
-            emit progress_updated("Error extracting " + folder + " from " + pak_file + ": " + process.errorString());
+            report_error("Error extracting " + folder + " from " + pak_file + ": " + process.errorString());
+            extracted = false;
         }
     }
+    return extracted;
 }
 
 bool PakScanner::checkDivine() {
@@ -200,35 +794,72 @@ bool PakScanner::checkDivine() {
     return true;
 }
 
-void PakScanner::process_extracted_files(const QString &extract_dir) {
+void PakScanner::process_extracted_files(const QString &extract_dir, const QByteArray &fingerprint, PakScanResult &result) {
     QString localization_dir = extract_dir + "/Localization";
     QString mods_dir = extract_dir + "/Mods";
 
     if (QDir(localization_dir).exists()) {
-        process_localization(localization_dir);
+        process_localization(localization_dir, fingerprint, result);
     }
 
     if (QDir(mods_dir).exists()) {
-        process_mods(mods_dir);
+        process_mods(mods_dir, result);
     }
 }
 
-void PakScanner::process_localization(const QString &localization_dir) {
+void PakScanner::process_localization(const QString &localization_dir, const QByteArray &fingerprint, PakScanResult &result) {
     QDir dir(localization_dir);
     QStringList lang_dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
     for (const QString &lang_dir : lang_dirs) {
-        emit progress_updated("Found localization for language: " + lang_dir);
-        // Add logic to process localization files here later
+        if (control.is_cancelled()) {
+            return;
+        }
+        report_progress("Found localization for language: " + lang_dir);
+        result.languages << lang_dir;
+
+        QVector<LocalizationFile::Entry> strings;
+        QDirIterator it(localization_dir + "/" + lang_dir, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            QString file = it.next();
+            if (!LocalizationFile::is_localization_file(file)) {
+                continue;
+            }
+            QString error;
+            qint64 bytes_read = 0;
+            if (!LocalizationFile::read(file, strings, error, &bytes_read)) {
+                report_error("Error reading localization file " + file + ": " + error);
+            }
+            metrics.add(ScanMetrics::BytesRead, bytes_read);
+        }
+        result.string_counts[lang_dir] += strings.size();
+        if (!fingerprint.isEmpty()) {
+            snapshot_builder.add(fingerprint, lang_dir, strings);
+        }
     }
 }
 
-void PakScanner::process_mods(const QString &mods_dir) {
+void PakScanner::process_mods(const QString &mods_dir, PakScanResult &result) {
     QDir dir(mods_dir);
     QStringList subdirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
     for (const QString &subdir : subdirs) {
+        if (control.is_cancelled()) {
+            return;
+        }
+        // Only reached when divine had to extract Mods/ without a readable file table
+        bool known = false;
+        for (const ModuleMeta &module : result.modules) {
+            known = known || module.folder.compare(subdir, Qt::CaseInsensitive) == 0;
+        }
+        LsResource meta;
+        ModuleMeta module;
+        if (!known && meta.read(mods_dir + "/" + subdir + "/meta.lsx") && read_module_meta(meta, module)) {
+            result.modules << module;
+        }
+
         QString mcm_blueprint = mods_dir + "/" + subdir + "/MCM_blueprint.json";
         if (QFile::exists(mcm_blueprint)) {
-            emit progress_updated("Found MCM_blueprint.json in " + subdir);
+            report_progress("Found MCM_blueprint.json in " + subdir);
+            result.mcm_mods << subdir;
             // Add logic to process MCM_blueprint.json here later
         }
     }
@@ -236,11 +867,9 @@ void PakScanner::process_mods(const QString &mods_dir) {
 
 void PakScanner::cleanup_temp_files() {
     if (!retain_temp_files && QDir(temp_path).exists()) {
-        QDir dir(temp_path);
-        if (dir.removeRecursively()) {
-            emit progress_updated("Cleaned up temporary files in " + temp_path);
-        } else {
-            emit progress_updated("Error cleaning up temporary files in " + temp_path);
+        ScanMetrics::StageTimer stage_timer(metrics, ScanMetrics::StageCleanup);
+        if (!temp_cleaner->schedule(temp_path)) {
+            report_error("Error cleaning up temporary files in " + temp_path);
         }
     }
 }
\ No newline at end of file
@@ -14,7 +14,32 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QTimer>
-#include <QEventLoop>
+#include "scanmetrics.h"
+#include "progressaggregator.h"
+#include "scancontrol.h"
+#include "scancheckpoint.h"
+#include "scanscheduler.h"
+#include "pakfingerprint.h"
+#include "pakresultcache.h"
+#include "streamingdownload.h"
+#include "ziparchive.h"
+#include "divineversionresolver.h"
+#include "toolcache.h"
+#include "tempcleaner.h"
+#include "scratchpool.h"
+#include "lspkreader.h"
+#include "localizationfile.h"
+#include "scandatabase.h"
+#include "locasnapshot.h"
+#include "vanillabaseline.h"
+#include "modsettings.h"
+#include "vortexdeployment.h"
+#include "lsresource.h"
+#include "moddependencygraph.h"
+#include <QThreadPool>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
 
 class PakScanner : public QObject {
     Q_OBJECT
@@ -22,37 +47,115 @@ class PakScanner : public QObject {
 public:
     bool checkDivine();
     explicit PakScanner(QObject *parent = nullptr);
+    ~PakScanner() override;
     void set_temp_path(const QString &path);
     void set_retain_temp_files(bool retain);
+    void set_prefer_tmpfs(bool prefer);
+    QString current_temp_path() const;
+    void set_divine_sha256(const QByteArray &hex_digest);
+    void set_release_url(const QString &url);
+    bool use_divine_version(const QString &version);
+    QString current_divine_version() const;
     void scan_mod_folder(const QString &mod_folder, const QString &mod_manager);
+    void scan_mods(const QStringList &mod_folders, const QString &mod_manager, bool resume = false);
+    bool is_scanning() const;
+    void prioritize_mods(const QStringList &mod_folders, ScanScheduler::Priority priority);
+    void set_visible_mods(const QStringList &mod_folders);
+    bool has_checkpoint();
+    const ScanMetrics &scan_metrics() const;
+    const ProgressAggregator *scan_progress() const;
+    ScanDatabase &scan_database();
+    // Current snapshot; holders keep theirs valid across later scans.
+    QSharedPointer<const LocaSnapshot> localization_snapshot() const;
+    const VanillaBaseline &vanilla_baseline() const;
+    // Blocking, indexes the game's own localization packages under data_dir.
+    bool build_vanilla_baseline(const QString &data_dir, QString &error);
 
     signals:
         void progress_updated(const QString &message);
     void divine_not_found();
     void divine_download_progress(qint64 bytesReceived, qint64 bytesTotal);
     void divine_download_finished();
+    void scan_finished(bool completed);
 
     public slots:
         void set_divine_path(const QString &path);
     void download_divine();
+    void refresh_divine_version();
+    void cancel_scan();
+    void pause_scan();
+    void resume_scan();
 
 private:
     QString divine_path;
+    QString divine_version;
+    ToolCache tool_cache;
+    QByteArray divine_expected_sha256;
+    QString release_url;
     QString temp_path;
     bool retain_temp_files;
     QNetworkAccessManager *network_manager;
+    DivineVersionResolver *version_resolver;
+    bool download_pending;
     QTimer *timer;
+    ScanMetrics metrics;
+    ProgressAggregator *progress;
+    TempCleaner *temp_cleaner;
+    QThreadPool *scan_pool;
+    ScanControl control;
+    ScanCheckpoint checkpoint;
+    PakResultCache result_cache;
+    ScratchPool scratch_pool;
+    ScanScheduler scheduler;
+    ScanDatabase database;
+    mutable QMutex snapshot_lock;
+    QSharedPointer<LocaSnapshot> snapshot;
+    quint64 snapshot_generation;
+    LocaSnapshotBuilder snapshot_builder;
+    QString snapshot_path;
+    bool resumed_scan;
+    QStringList scanned_mods;  // expanded scan items of the running scan
+    QMutex failed_paks_lock;
+    QStringList failed_paks;
+    VanillaBaseline vanilla;
+    QString vanilla_path;
+    QAtomicInt scanning;
+    QMutex file_ids_lock;
+    QSet<QByteArray> scanned_file_ids;
+    QMutex part_counts_lock;
+    QHash<QString, int> part_counts;  // main package -> parts, per scan
+    QAtomicInt active_workers;
 
     bool check_divine_exists();
-    QString get_latest_divine_version();
+    static QString default_temp_path();
+    void report_progress(const QString &message);
+    void report_error(const QString &message);
+    void start_divine_download(const QString &version);
+    void on_divine_version_resolved(const QString &version);
+    void on_divine_version_failed(const QString &error);
+    void run_scan_worker(const QString &mod_manager);
+    QHash<QString, QStringList> scan_dependencies(const QStringList &jobs);
+    void finish_scan();
+    QString snapshot_file(quint64 generation) const;
+    void open_latest_snapshot();
+    void write_snapshot(bool prune);
     QStringList find_pak_files(const QString &folder);
-    void process_pak_file(const QString &pak_file);
-    void extract_pak(const QString &pak_file, const QString &extract_dir, const QStringList &folders_to_extract);
-    void process_extracted_files(const QString &extract_dir);
-    void process_localization(const QString &localization_dir);
-    void process_mods(const QString &mods_dir);
+    QStringList load_order_pak_files(const QString &mods_dir);
+    bool is_secondary_part(const QString &pak_file);
+    bool claim_file(const QString &pak_file);
+    bool process_pak_file(const QString &mod_folder, const QString &pak_file);
+    void record_pak(const QString &mod_folder, const QString &pak_file, const QByteArray &fingerprint,
+                    const PakScanResult &result, qint64 scan_usec, bool from_cache);
+    QStringList relevant_folders(const QString &pak_file, PakScanResult &result);
+    static bool read_module_meta(const LsResource &meta, ModuleMeta &module);
+    bool extract_pak(const QString &pak_file, const QString &extract_dir, const QStringList &folders_to_extract);
+    void process_extracted_files(const QString &extract_dir, const QByteArray &fingerprint, PakScanResult &result);
+    void report_result(const PakScanResult &result);
+    void record_extracted_files(const QString &extract_dir);
+    void process_localization(const QString &localization_dir, const QByteArray &fingerprint, PakScanResult &result);
+    void process_mods(const QString &mods_dir, PakScanResult &result);
     void cleanup_temp_files();
-    void extract_divine_zip(const QString &zip_path, const QString &version);
+    void install_divine(const QString &zip_path, const QString &version, const QByteArray &sha256);
 };
 
 #endif
\ No newline at end of file
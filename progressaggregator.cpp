@@ -0,0 +1,120 @@
+#include "progressaggregator.h"
+#include <QMutexLocker>
+#include <QDebug>
+
+ProgressAggregator::ProgressAggregator(QObject *parent) : QObject(parent) {
+    recent.resize(recent_capacity);
+    recent_head = 0;
+    flush_timer = new QTimer(this);
+    flush_timer->setSingleShot(true);
+    connect(flush_timer, &QTimer::timeout, this, &ProgressAggregator::flush);
+    set_frame_rate(30);
+}
+
+void ProgressAggregator::set_frame_rate(int frames_per_second) {
+    flush_timer->setInterval(1000 / qMax(1, frames_per_second));
+}
+
+void ProgressAggregator::set_log_path(const QString &path) {
+    QMutexLocker locker(&mutex);
+    log.close();
+    log.setFileName(path);
+    if (!log.open(QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "Unable to open scan log:" << path << log.errorString();
+    }
+}
+
+void ProgressAggregator::report(const QString &message, Severity severity) {
+    {
+        QMutexLocker locker(&mutex);
+        QString entry = severity == Error ? "[error] " + message : message;
+        recent[recent_head] = entry;
+        recent_head = (recent_head + 1) % recent_capacity;
+        if (log.isOpen()) {
+            log.write(entry.toUtf8() + '\n');
+        }
+        latest = message;
+    }
+
+    events.fetchAndAddRelaxed(1);
+    if (severity == Error) {
+        errors.fetchAndAddRelaxed(1);
+    }
+
+    // Only the first event after a flush arms the timer, everything else just
+    // overwrites the latest message.
+    if (flush_scheduled.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!flush_timer->isActive()) {
+                flush_timer->start();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ProgressAggregator::flush() {
+    flush_scheduled.storeRelease(0);
+
+    QString message;
+    {
+        QMutexLocker locker(&mutex);
+        message = latest;
+        latest.clear();
+    }
+
+    if (!message.isEmpty()) {
+        emit progress_updated(message);
+    }
+}
+
+void ProgressAggregator::reset() {
+    QMutexLocker locker(&mutex);
+    for (QString &entry : recent) {
+        entry.clear();
+    }
+    recent_head = 0;
+    if (log.isOpen()) {
+        log.resize(0);
+        log.seek(0);
+    }
+    latest.clear();
+    events.storeRelaxed(0);
+    errors.storeRelaxed(0);
+}
+
+qint64 ProgressAggregator::event_count() const {
+    return events.loadRelaxed();
+}
+
+qint64 ProgressAggregator::error_count() const {
+    return errors.loadRelaxed();
+}
+
+QStringList ProgressAggregator::recent_events(int limit) const {
+    QMutexLocker locker(&mutex);
+    return recent_locked(limit);
+}
+
+QStringList ProgressAggregator::recent_locked(int limit) const {
+    QStringList result;
+    for (int i = recent_capacity - qBound(0, limit, recent_capacity); i < recent_capacity; ++i) {
+        const QString &entry = recent[(recent_head + i) % recent_capacity];
+        if (!entry.isEmpty()) {
+            result << entry;
+        }
+    }
+    return result;
+}
+
+QStringList ProgressAggregator::full_log() const {
+    QMutexLocker locker(&mutex);
+    if (!log.isOpen()) {
+        return recent_locked(recent_capacity);
+    }
+    log.flush();
+    QFile reader(log.fileName());
+    if (!reader.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QStringList();
+    }
+    return QString::fromUtf8(reader.readAll()).split('\n', Qt::SkipEmptyParts);
+}
@@ -0,0 +1,60 @@
+#ifndef PROGRESSAGGREGATOR_H
+#define PROGRESSAGGREGATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <QTimer>
+#include <QFile>
+
+// Collects progress events from any thread and pushes at most one coalesced
+// update per frame to the thread the aggregator lives on. Only the most recent
+// events stay in memory; the full log is spilled to a file.
+class ProgressAggregator : public QObject {
+    Q_OBJECT
+
+public:
+    enum Severity {
+        Info,
+        Error
+    };
+
+    static constexpr int recent_capacity = 256;
+
+    explicit ProgressAggregator(QObject *parent = nullptr);
+    void report(const QString &message, Severity severity = Info);
+    void set_frame_rate(int frames_per_second);
+    // Truncates the log file; without one only the recent events are kept.
+    void set_log_path(const QString &path);
+    void reset();
+
+    qint64 event_count() const;
+    qint64 error_count() const;
+    // Oldest first, at most limit of the last recent_capacity events.
+    QStringList recent_events(int limit = recent_capacity) const;
+    QStringList full_log() const;
+
+signals:
+    void progress_updated(const QString &message);
+
+public slots:
+    void flush();
+
+private:
+    QStringList recent_locked(int limit) const;
+
+    QTimer *flush_timer;
+    mutable QMutex mutex;
+    QVector<QString> recent;
+    int recent_head;
+    mutable QFile log;
+    QString latest;
+    QAtomicInteger<qint64> events;
+    QAtomicInteger<qint64> errors;
+    QAtomicInteger<int> flush_scheduled;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "scancheckpoint.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+// Write the checkpoint after this many newly completed paks.
+static const int save_interval = 25;
+
+ScanCheckpoint::ScanCheckpoint() : unsaved(0) {
+}
+
+void ScanCheckpoint::set_path(const QString &path) {
+    QMutexLocker locker(&mutex);
+    file_path = path;
+}
+
+ScanCheckpoint::PakStamp ScanCheckpoint::stamp_for(const QString &pak_file) {
+    QFileInfo info(pak_file);
+    return PakStamp{info.size(), info.lastModified().toMSecsSinceEpoch()};
+}
+
+bool ScanCheckpoint::load() {
+    QMutexLocker locker(&mutex);
+    completed.clear();
+    unsaved = 0;
+
+    QFile file(file_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonObject paks = QJsonDocument::fromJson(file.readAll()).object()["completed"].toObject();
+    for (auto it = paks.begin(); it != paks.end(); ++it) {
+        QJsonObject stamp = it.value().toObject();
+        completed.insert(it.key(), PakStamp{qint64(stamp["size"].toDouble()), qint64(stamp["modified"].toDouble())});
+    }
+    return true;
+}
+
+bool ScanCheckpoint::save() {
+    QMutexLocker locker(&mutex);
+    return save_locked();
+}
+
+bool ScanCheckpoint::save_locked() {
+    QJsonObject paks;
+    for (auto it = completed.constBegin(); it != completed.constEnd(); ++it) {
+        QJsonObject stamp;
+        stamp["size"] = it.value().size;
+        stamp["modified"] = it.value().modified;
+        paks[it.key()] = stamp;
+    }
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["completed"] = paks;
+
+    QSaveFile file(file_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    unsaved = 0;
+    return file.commit();
+}
+
+void ScanCheckpoint::clear() {
+    QMutexLocker locker(&mutex);
+    completed.clear();
+    unsaved = 0;
+    QFile::remove(file_path);
+}
+
+bool ScanCheckpoint::is_completed(const QString &pak_file) const {
+    PakStamp current = stamp_for(pak_file);
+
+    QMutexLocker locker(&mutex);
+    auto it = completed.constFind(pak_file);
+    if (it == completed.constEnd()) {
+        return false;
+    }
+    return current.size == it.value().size && current.modified == it.value().modified;
+}
+
+void ScanCheckpoint::mark_completed(const QString &pak_file) {
+    PakStamp stamp = stamp_for(pak_file);
+
+    QMutexLocker locker(&mutex);
+    completed.insert(pak_file, stamp);
+    if (++unsaved >= save_interval) {
+        save_locked();
+    }
+}
+
+int ScanCheckpoint::completed_count() const {
+    QMutexLocker locker(&mutex);
+    return completed.size();
+}
@@ -0,0 +1,38 @@
+#ifndef SCANCHECKPOINT_H
+#define SCANCHECKPOINT_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+// Persistent record of the paks a scan has already finished, so an interrupted
+// scan can pick up where it stopped. A pak only counts as done while its size
+// and modification time are unchanged.
+class ScanCheckpoint {
+public:
+    ScanCheckpoint();
+    void set_path(const QString &path);
+    bool load();
+    bool save();
+    void clear();
+
+    bool is_completed(const QString &pak_file) const;
+    void mark_completed(const QString &pak_file);
+    int completed_count() const;
+
+private:
+    struct PakStamp {
+        qint64 size;
+        qint64 modified;
+    };
+
+    static PakStamp stamp_for(const QString &pak_file);
+    bool save_locked();
+
+    QString file_path;
+    mutable QMutex mutex;
+    QHash<QString, PakStamp> completed;
+    int unsaved;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "scancontrol.h"
+#include <QMutexLocker>
+
+ScanControl::ScanControl() {
+    reset();
+}
+
+void ScanControl::cancel() {
+    QMutexLocker locker(&mutex);
+    cancelled.storeRelease(1);
+    resumed.wakeAll();
+}
+
+void ScanControl::pause() {
+    QMutexLocker locker(&mutex);
+    paused.storeRelease(1);
+}
+
+void ScanControl::resume() {
+    QMutexLocker locker(&mutex);
+    paused.storeRelease(0);
+    resumed.wakeAll();
+}
+
+void ScanControl::reset() {
+    QMutexLocker locker(&mutex);
+    cancelled.storeRelease(0);
+    paused.storeRelease(0);
+}
+
+bool ScanControl::is_cancelled() const {
+    return cancelled.loadAcquire() != 0;
+}
+
+bool ScanControl::is_paused() const {
+    return paused.loadAcquire() != 0;
+}
+
+bool ScanControl::wait_while_paused() {
+    if (!is_paused()) {
+        return !is_cancelled();
+    }
+
+    QMutexLocker locker(&mutex);
+    while (is_paused() && !is_cancelled()) {
+        resumed.wait(&mutex);
+    }
+    return !is_cancelled();
+}
@@ -0,0 +1,30 @@
+#ifndef SCANCONTROL_H
+#define SCANCONTROL_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+
+// Cooperative cancellation and pause token shared by the scan workers.
+class ScanControl {
+public:
+    ScanControl();
+    void cancel();
+    void pause();
+    void resume();
+    void reset();
+
+    bool is_cancelled() const;
+    bool is_paused() const;
+
+    // Blocks while the scan is paused. Returns false once the scan is cancelled.
+    bool wait_while_paused();
+
+private:
+    QAtomicInt cancelled;
+    QAtomicInt paused;
+    QMutex mutex;
+    QWaitCondition resumed;
+};
+
+#endif
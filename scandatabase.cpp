@@ -0,0 +1,455 @@
+#include "scandatabase.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QHash>
+#include <QMutexLocker>
+#include <QDebug>
+
+static const char *schema[] = {
+    "PRAGMA journal_mode=WAL",
+    "PRAGMA synchronous=NORMAL",
+    "PRAGMA foreign_keys=ON",
+    "CREATE TABLE IF NOT EXISTS mods ("
+    " id INTEGER PRIMARY KEY,"
+    " name TEXT NOT NULL,"
+    " path TEXT NOT NULL UNIQUE,"
+    " last_scanned INTEGER)",
+    "CREATE TABLE IF NOT EXISTS paks ("
+    " id INTEGER PRIMARY KEY,"
+    " mod_id INTEGER NOT NULL REFERENCES mods(id) ON DELETE CASCADE,"
+    " path TEXT NOT NULL UNIQUE,"
+    " size INTEGER,"
+    " modified INTEGER,"
+    " fingerprint TEXT,"
+    " has_mcm INTEGER,"
+    " scan_usec INTEGER,"
+    " from_cache INTEGER,"
+    " scanned_at INTEGER,"
+    " scan_id INTEGER)",
+    "CREATE TABLE IF NOT EXISTS pak_languages ("
+    " pak_id INTEGER NOT NULL REFERENCES paks(id) ON DELETE CASCADE,"
+    " language TEXT NOT NULL,"
+    " string_count INTEGER,"
+    " PRIMARY KEY (pak_id, language))",
+    "CREATE TABLE IF NOT EXISTS pak_mcm ("
+    " pak_id INTEGER NOT NULL REFERENCES paks(id) ON DELETE CASCADE,"
+    " mod_name TEXT NOT NULL)",
+    "CREATE TABLE IF NOT EXISTS pak_modules ("
+    " pak_id INTEGER NOT NULL REFERENCES paks(id) ON DELETE CASCADE,"
+    " uuid TEXT NOT NULL,"
+    " folder TEXT,"
+    " name TEXT,"
+    " version TEXT,"
+    " dependencies TEXT,"
+    " dependency_names TEXT)",
+    "CREATE INDEX IF NOT EXISTS idx_paks_mod ON paks(mod_id)",
+    "CREATE INDEX IF NOT EXISTS idx_paks_fingerprint ON paks(fingerprint)",
+    "CREATE INDEX IF NOT EXISTS idx_languages_language ON pak_languages(language)",
+    "CREATE INDEX IF NOT EXISTS idx_modules_uuid ON pak_modules(uuid)",
+};
+
+// Upper bound on rows per transaction, so readers see progress during a scan.
+static const int max_batch = 500;
+
+ScanDatabase::ScanDatabase() : writer(nullptr), current_scan(0), pending_prune(0), writing(false), stopping(false) {
+}
+
+ScanDatabase::~ScanDatabase() {
+    close();
+}
+
+QString ScanDatabase::error_string() const {
+    QMutexLocker locker(&mutex);
+    return error;
+}
+
+bool ScanDatabase::open(const QString &path) {
+    close();
+    database_path = path;
+    writer_connection = "scan_results_writer_" + QString::number(quintptr(this));
+
+    // Create the schema up front so readers never see a missing table.
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", writer_connection);
+        db.setDatabaseName(database_path);
+        bool ready = db.open() && create_schema(writer_connection);
+        if (!ready) {
+            error = db.lastError().text();
+        }
+        db.close();
+        if (!ready) {
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(writer_connection);
+            return false;
+        }
+    }
+    QSqlDatabase::removeDatabase(writer_connection);
+
+    stopping = false;
+    writer = QThread::create([this]() {
+        writer_loop();
+    });
+    writer->start(QThread::LowPriority);
+    return true;
+}
+
+void ScanDatabase::close() {
+    QString reader = reader_connection_name();
+    if (QSqlDatabase::contains(reader)) {
+        QSqlDatabase::removeDatabase(reader);
+    }
+    if (!writer) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        queue_changed.wakeAll();
+    }
+    writer->wait();
+    delete writer;
+    writer = nullptr;
+}
+
+bool ScanDatabase::create_schema(const QString &connection) {
+    QSqlQuery query(QSqlDatabase::database(connection, false));
+    for (const char *statement : schema) {
+        if (!query.exec(statement)) {
+            qWarning() << "Scan database schema error:" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ScanDatabase::begin_scan() {
+    QMutexLocker locker(&mutex);
+    current_scan = QDateTime::currentMSecsSinceEpoch();
+}
+
+void ScanDatabase::record(const PakRecord &record) {
+    QMutexLocker locker(&mutex);
+    queue << record;
+    queue_changed.wakeOne();
+}
+
+void ScanDatabase::prune_unseen(const QStringList &mod_paths, const QStringList &kept_paks) {
+    QMutexLocker locker(&mutex);
+    if (current_scan != 0) {
+        pending_prune = current_scan;
+        prune_mods = mod_paths;
+        prune_kept = kept_paks;
+        queue_changed.wakeOne();
+    }
+}
+
+void ScanDatabase::flush() {
+    QMutexLocker locker(&mutex);
+    while (writer && (!queue.isEmpty() || pending_prune != 0 || writing)) {
+        queue_drained.wait(&mutex);
+    }
+}
+
+void ScanDatabase::writer_loop() {
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", writer_connection);
+        db.setDatabaseName(database_path);
+        if (!db.open()) {
+            QMutexLocker locker(&mutex);
+            error = db.lastError().text();
+        }
+        QSqlQuery(db).exec("PRAGMA foreign_keys=ON");
+
+        for (;;) {
+            QVector<PakRecord> batch;
+            qint64 scan_id = 0;
+            qint64 prune_scan = 0;
+            QStringList mod_paths;
+            QStringList kept_paks;
+            {
+                QMutexLocker locker(&mutex);
+                while (queue.isEmpty() && pending_prune == 0 && !stopping) {
+                    queue_drained.wakeAll();
+                    queue_changed.wait(&mutex);
+                }
+                if (queue.isEmpty() && pending_prune == 0 && stopping) {
+                    break;
+                }
+                int count = qMin(int(queue.size()), max_batch);
+                batch = queue.mid(0, count);
+                queue.remove(0, count);
+                scan_id = current_scan;
+                // Pruning waits until every record queued before it is written
+                if (queue.isEmpty()) {
+                    prune_scan = pending_prune;
+                    pending_prune = 0;
+                    mod_paths.swap(prune_mods);
+                    kept_paks.swap(prune_kept);
+                }
+                writing = true;
+            }
+
+            bool written = db.isOpen() && (batch.isEmpty() || write_batch(batch, scan_id))
+                           && (prune_scan == 0 || prune(prune_scan, mod_paths, kept_paks));
+
+            QMutexLocker locker(&mutex);
+            writing = false;
+            if (!written) {
+                error = db.lastError().text();
+            }
+            if (queue.isEmpty()) {
+                queue_drained.wakeAll();
+            }
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(writer_connection);
+
+    QMutexLocker locker(&mutex);
+    queue_drained.wakeAll();
+}
+
+bool ScanDatabase::write_batch(const QVector<PakRecord> &batch, qint64 scan_id) {
+    QSqlDatabase db = QSqlDatabase::database(writer_connection, false);
+    if (!db.transaction()) {
+        return false;
+    }
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QHash<QString, qint64> mod_ids;
+
+    QSqlQuery upsert_mod(db);
+    upsert_mod.prepare("INSERT INTO mods (name, path, last_scanned) VALUES (?, ?, ?) "
+                       "ON CONFLICT(path) DO UPDATE SET name = excluded.name, last_scanned = excluded.last_scanned");
+    QSqlQuery select_mod(db);
+    select_mod.prepare("SELECT id FROM mods WHERE path = ?");
+    QSqlQuery upsert_pak(db);
+    upsert_pak.prepare("INSERT INTO paks (mod_id, path, size, modified, fingerprint, has_mcm, scan_usec, from_cache, scanned_at, scan_id) "
+                       "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+                       "ON CONFLICT(path) DO UPDATE SET mod_id = excluded.mod_id, size = excluded.size, "
+                       "modified = excluded.modified, fingerprint = excluded.fingerprint, has_mcm = excluded.has_mcm, "
+                       "scan_usec = excluded.scan_usec, from_cache = excluded.from_cache, scanned_at = excluded.scanned_at, "
+                       "scan_id = excluded.scan_id");
+    QSqlQuery select_pak(db);
+    select_pak.prepare("SELECT id FROM paks WHERE path = ?");
+    QSqlQuery delete_languages(db);
+    delete_languages.prepare("DELETE FROM pak_languages WHERE pak_id = ?");
+    QSqlQuery delete_mcm(db);
+    delete_mcm.prepare("DELETE FROM pak_mcm WHERE pak_id = ?");
+    QSqlQuery insert_language(db);
+    insert_language.prepare("INSERT INTO pak_languages (pak_id, language, string_count) VALUES (?, ?, ?)");
+    QSqlQuery insert_mcm(db);
+    insert_mcm.prepare("INSERT INTO pak_mcm (pak_id, mod_name) VALUES (?, ?)");
+    QSqlQuery delete_modules(db);
+    delete_modules.prepare("DELETE FROM pak_modules WHERE pak_id = ?");
+    QSqlQuery insert_module(db);
+    insert_module.prepare("INSERT INTO pak_modules (pak_id, uuid, folder, name, version, dependencies, dependency_names) VALUES (?, ?, ?, ?, ?, ?, ?)");
+
+    for (const PakRecord &record : batch) {
+        auto mod_it = mod_ids.constFind(record.mod_path);
+        if (mod_it == mod_ids.constEnd()) {
+            upsert_mod.addBindValue(record.mod_name);
+            upsert_mod.addBindValue(record.mod_path);
+            upsert_mod.addBindValue(now);
+            select_mod.addBindValue(record.mod_path);
+            if (!upsert_mod.exec() || !select_mod.exec() || !select_mod.next()) {
+                db.rollback();
+                return false;
+            }
+            mod_it = mod_ids.insert(record.mod_path, select_mod.value(0).toLongLong());
+            select_mod.finish();
+        }
+
+        upsert_pak.addBindValue(mod_it.value());
+        upsert_pak.addBindValue(record.pak_path);
+        upsert_pak.addBindValue(record.size);
+        upsert_pak.addBindValue(record.modified);
+        upsert_pak.addBindValue(QString::fromLatin1(record.fingerprint));
+        upsert_pak.addBindValue(!record.result.mcm_mods.isEmpty());
+        upsert_pak.addBindValue(record.scan_usec);
+        upsert_pak.addBindValue(record.from_cache);
+        upsert_pak.addBindValue(now);
+        upsert_pak.addBindValue(scan_id);
+        select_pak.addBindValue(record.pak_path);
+        if (!upsert_pak.exec() || !select_pak.exec() || !select_pak.next()) {
+            db.rollback();
+            return false;
+        }
+        qint64 pak_id = select_pak.value(0).toLongLong();
+        select_pak.finish();
+
+        delete_languages.addBindValue(pak_id);
+        delete_mcm.addBindValue(pak_id);
+        delete_modules.addBindValue(pak_id);
+        if (!delete_languages.exec() || !delete_mcm.exec() || !delete_modules.exec()) {
+            db.rollback();
+            return false;
+        }
+        for (const QString &language : record.result.languages) {
+            insert_language.addBindValue(pak_id);
+            insert_language.addBindValue(language);
+            insert_language.addBindValue(record.result.string_counts.value(language));
+            if (!insert_language.exec()) {
+                db.rollback();
+                return false;
+            }
+        }
+        for (const QString &mod : record.result.mcm_mods) {
+            insert_mcm.addBindValue(pak_id);
+            insert_mcm.addBindValue(mod);
+            if (!insert_mcm.exec()) {
+                db.rollback();
+                return false;
+            }
+        }
+        for (const ModuleMeta &module : record.result.modules) {
+            insert_module.addBindValue(pak_id);
+            insert_module.addBindValue(module.uuid);
+            insert_module.addBindValue(module.folder);
+            insert_module.addBindValue(module.name);
+            insert_module.addBindValue(module.version);
+            insert_module.addBindValue(module.dependencies.join(','));
+            insert_module.addBindValue(module.dependency_names.join('\n'));
+            if (!insert_module.exec()) {
+                db.rollback();
+                return false;
+            }
+        }
+    }
+
+    return db.commit();
+}
+
+bool ScanDatabase::prune(qint64 scan_id, const QStringList &mod_paths, const QStringList &kept_paks) {
+    QSqlDatabase db = QSqlDatabase::database(writer_connection, false);
+    if (!db.transaction()) {
+        return false;
+    }
+    QSqlQuery keep(db);
+    keep.prepare("UPDATE paks SET scan_id = ? WHERE path = ?");
+    for (const QString &pak_path : kept_paks) {
+        keep.addBindValue(scan_id);
+        keep.addBindValue(pak_path);
+        if (!keep.exec()) {
+            db.rollback();
+            return false;
+        }
+    }
+
+    // Only mods that were part of this scan; other mods and profiles keep
+    // their results. Languages, MCM entries and modules go with their pak
+    // (ON DELETE CASCADE).
+    QSqlQuery remove_paks(db);
+    remove_paks.prepare("DELETE FROM paks WHERE (scan_id IS NULL OR scan_id <> ?) "
+                        "AND mod_id IN (SELECT id FROM mods WHERE path = ?)");
+    QSqlQuery remove_mod(db);
+    remove_mod.prepare("DELETE FROM mods WHERE path = ? AND id NOT IN (SELECT mod_id FROM paks)");
+    for (const QString &mod_path : mod_paths) {
+        remove_paks.addBindValue(scan_id);
+        remove_paks.addBindValue(mod_path);
+        remove_mod.addBindValue(mod_path);
+        if (!remove_paks.exec() || !remove_mod.exec()) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+QString ScanDatabase::reader_connection_name() const {
+    return "scan_results_reader_" + QString::number(quintptr(this)) + "_" + QString::number(quintptr(QThread::currentThreadId()));
+}
+
+QString ScanDatabase::reader_connection() {
+    QString name = reader_connection_name();
+    if (!QSqlDatabase::contains(name)) {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(database_path);
+        db.open();
+    }
+    return name;
+}
+
+QVector<ModSummary> ScanDatabase::query_summaries(const QString &where, const QStringList &values) {
+    QVector<ModSummary> summaries;
+    QSqlQuery query(QSqlDatabase::database(reader_connection()));
+    query.prepare("SELECT m.name, m.path, COUNT(DISTINCT p.id), GROUP_CONCAT(DISTINCT l.language), "
+                  "COALESCE(SUM(l.string_count), 0), COALESCE(MAX(p.has_mcm), 0) "
+                  "FROM mods m LEFT JOIN paks p ON p.mod_id = m.id LEFT JOIN pak_languages l ON l.pak_id = p.id "
+                  + where + " GROUP BY m.id ORDER BY m.name");
+    for (const QString &value : values) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        QMutexLocker locker(&mutex);
+        error = query.lastError().text();
+        return summaries;
+    }
+
+    while (query.next()) {
+        ModSummary summary;
+        summary.name = query.value(0).toString();
+        summary.path = query.value(1).toString();
+        summary.paks = query.value(2).toInt();
+        QString languages = query.value(3).toString();
+        if (!languages.isEmpty()) {
+            summary.languages = languages.split(',');
+        }
+        summary.strings = query.value(4).toLongLong();
+        summary.has_mcm = query.value(5).toBool();
+        summaries << summary;
+    }
+    return summaries;
+}
+
+QHash<QString, QByteArrayList> ScanDatabase::pak_fingerprints() {
+    QHash<QString, QByteArrayList> fingerprints;
+    QSqlQuery query(QSqlDatabase::database(reader_connection()));
+    if (!query.exec("SELECT m.path, p.fingerprint FROM paks p JOIN mods m ON m.id = p.mod_id WHERE p.fingerprint <> ''")) {
+        QMutexLocker locker(&mutex);
+        error = query.lastError().text();
+        return fingerprints;
+    }
+    while (query.next()) {
+        fingerprints[query.value(0).toString()] << query.value(1).toString().toLatin1();
+    }
+    return fingerprints;
+}
+
+QVector<ModModule> ScanDatabase::mod_modules() {
+    QVector<ModModule> modules;
+    QSqlQuery query(QSqlDatabase::database(reader_connection()));
+    if (!query.exec("SELECT m.path, p.path, d.uuid, d.folder, d.name, d.version, d.dependencies, d.dependency_names "
+                    "FROM pak_modules d JOIN paks p ON p.id = d.pak_id JOIN mods m ON m.id = p.mod_id ORDER BY m.path, p.path")) {
+        QMutexLocker locker(&mutex);
+        error = query.lastError().text();
+        return modules;
+    }
+    while (query.next()) {
+        ModModule module;
+        module.mod_path = query.value(0).toString();
+        module.pak_path = query.value(1).toString();
+        module.meta.uuid = query.value(2).toString();
+        module.meta.folder = query.value(3).toString();
+        module.meta.name = query.value(4).toString();
+        module.meta.version = query.value(5).toString();
+        QString dependencies = query.value(6).toString();
+        if (!dependencies.isEmpty()) {
+            module.meta.dependencies = dependencies.split(',');
+            module.meta.dependency_names = query.value(7).toString().split('\n');
+        }
+        modules << module;
+    }
+    return modules;
+}
+
+QVector<ModSummary> ScanDatabase::mod_summaries() {
+    return query_summaries(QString(), QStringList());
+}
+
+QVector<ModSummary> ScanDatabase::mods_with_language(const QString &language) {
+    return query_summaries("WHERE m.id IN (SELECT p2.mod_id FROM paks p2 JOIN pak_languages l2 ON l2.pak_id = p2.id WHERE l2.language = ?)",
+                           QStringList() << language);
+}
@@ -0,0 +1,100 @@
+#ifndef SCANDATABASE_H
+#define SCANDATABASE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QByteArrayList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include "pakresultcache.h"
+
+// One pak as seen by a scan, queued by the workers for the database writer.
+struct PakRecord {
+    QString mod_name;
+    QString mod_path;
+    QString pak_path;
+    qint64 size = 0;
+    qint64 modified = 0;
+    QByteArray fingerprint;
+    PakScanResult result;
+    qint64 scan_usec = 0;
+    bool from_cache = false;
+};
+
+struct ModSummary {
+    QString name;
+    QString path;
+    int paks = 0;
+    QStringList languages;
+    qint64 strings = 0;
+    bool has_mcm = false;
+};
+
+// A module found in one of a mod's paks.
+struct ModModule {
+    QString mod_path;
+    QString pak_path;
+    ModuleMeta meta;
+};
+
+// SQLite (WAL) store for scan results. Workers only append to an in-memory
+// queue; a single writer thread drains it in batches, one transaction per
+// batch. Readers on other threads get their own connection and are never
+// blocked by the writer.
+class ScanDatabase {
+public:
+    ScanDatabase();
+    ~ScanDatabase();
+
+    bool open(const QString &path);
+    void close();
+    QString error_string() const;
+
+    // Starts a scan; paks recorded from now on belong to it.
+    void begin_scan();
+    void record(const PakRecord &record);
+    // Queues removal of the paks of mod_paths not recorded since begin_scan,
+    // and of mods left without any; only meaningful after a completed scan of
+    // those mods. kept_paks were seen but could not be scanned, their previous
+    // results stay.
+    void prune_unseen(const QStringList &mod_paths, const QStringList &kept_paks);
+    // Blocks until everything queued so far is committed.
+    void flush();
+
+    QVector<ModSummary> mod_summaries();
+    QVector<ModSummary> mods_with_language(const QString &language);
+    // Fingerprints of the paks last seen in each mod, keyed by mod path.
+    QHash<QString, QByteArrayList> pak_fingerprints();
+    // meta.lsx identities of every scanned mod, in mod path order.
+    QVector<ModModule> mod_modules();
+
+private:
+    void writer_loop();
+    bool write_batch(const QVector<PakRecord> &batch, qint64 scan_id);
+    bool prune(qint64 scan_id, const QStringList &mod_paths, const QStringList &kept_paks);
+    bool create_schema(const QString &connection);
+    QString reader_connection_name() const;
+    QString reader_connection();
+    QVector<ModSummary> query_summaries(const QString &where, const QStringList &values);
+
+    QString database_path;
+    QString writer_connection;
+    QThread *writer;
+    mutable QMutex mutex;
+    QWaitCondition queue_changed;
+    QWaitCondition queue_drained;
+    QVector<PakRecord> queue;
+    qint64 current_scan;
+    qint64 pending_prune;  // scan id whose leftovers are to be removed, or 0
+    QStringList prune_mods;
+    QStringList prune_kept;
+    bool writing;
+    bool stopping;
+    QString error;
+};
+
+#endif
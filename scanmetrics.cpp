@@ -0,0 +1,193 @@
+#include "scanmetrics.h"
+#include <QJsonArray>
+
+static int bucket_for(qint64 usec) {
+    int bucket = 0;
+    while (usec > 0 && bucket < LatencyHistogram::bucket_count - 1) {
+        usec >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::record(qint64 usec) {
+    if (usec < 0) {
+        usec = 0;
+    }
+    buckets[bucket_for(usec)].fetchAndAddRelaxed(1);
+    samples.fetchAndAddRelaxed(1);
+    total.fetchAndAddRelaxed(usec);
+
+    qint64 current = maximum.loadRelaxed();
+    while (usec > current && !maximum.testAndSetRelaxed(current, usec, current)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < bucket_count; ++i) {
+        buckets[i].storeRelaxed(0);
+    }
+    samples.storeRelaxed(0);
+    total.storeRelaxed(0);
+    maximum.storeRelaxed(0);
+}
+
+qint64 LatencyHistogram::count() const {
+    return samples.loadRelaxed();
+}
+
+qint64 LatencyHistogram::total_usec() const {
+    return total.loadRelaxed();
+}
+
+qint64 LatencyHistogram::max_usec() const {
+    return maximum.loadRelaxed();
+}
+
+qint64 LatencyHistogram::percentile_usec(double percentile) const {
+    qint64 n = count();
+    if (n == 0) {
+        return 0;
+    }
+
+    // Bucket upper bounds are only accurate to a factor of two, which is plenty
+    // to tell a 2 ms stage from a 200 ms one.
+    qint64 target = qMax<qint64>(1, qint64(percentile * n + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < bucket_count; ++i) {
+        seen += buckets[i].loadRelaxed();
+        if (seen >= target) {
+            return qMin(max_usec(), i == 0 ? qint64(0) : (qint64(1) << i) - 1);
+        }
+    }
+    return max_usec();
+}
+
+QJsonObject LatencyHistogram::to_json() const {
+    QJsonObject json;
+    json["count"] = count();
+    json["total_usec"] = total_usec();
+    json["max_usec"] = max_usec();
+    json["p50_usec"] = percentile_usec(0.50);
+    json["p90_usec"] = percentile_usec(0.90);
+    json["p99_usec"] = percentile_usec(0.99);
+
+    QJsonArray histogram;
+    for (int i = 0; i < bucket_count; ++i) {
+        histogram.append(buckets[i].loadRelaxed());
+    }
+    json["log2_buckets"] = histogram;
+    return json;
+}
+
+ScanMetrics::StageTimer::StageTimer(ScanMetrics &metrics, Stage stage) : metrics(metrics), stage(stage) {
+    timer.start();
+}
+
+ScanMetrics::StageTimer::~StageTimer() {
+    metrics.record(stage, timer.nsecsElapsed() / 1000);
+}
+
+ScanMetrics::ScanMetrics() {
+    reset();
+}
+
+void ScanMetrics::add(Counter counter, qint64 amount) {
+    counters[counter].fetchAndAddRelaxed(amount);
+}
+
+void ScanMetrics::record(Stage stage, qint64 usec) {
+    stages[stage].record(usec);
+}
+
+void ScanMetrics::reset() {
+    for (int i = 0; i < CounterCount; ++i) {
+        counters[i].storeRelaxed(0);
+    }
+    for (int i = 0; i < StageCount; ++i) {
+        stages[i].reset();
+    }
+    scan_timer.start();
+}
+
+qint64 ScanMetrics::value(Counter counter) const {
+    return counters[counter].loadRelaxed();
+}
+
+double ScanMetrics::cache_hit_ratio() const {
+    qint64 hits = value(IndexCacheHits);
+    qint64 lookups = hits + value(IndexCacheMisses);
+    return lookups == 0 ? 0.0 : double(hits) / double(lookups);
+}
+
+qint64 ScanMetrics::elapsed_msec() const {
+    return scan_timer.elapsed();
+}
+
+QJsonObject ScanMetrics::to_json() const {
+    QJsonObject counter_json;
+    for (int i = 0; i < CounterCount; ++i) {
+        counter_json[counter_name(Counter(i))] = value(Counter(i));
+    }
+
+    QJsonObject stage_json;
+    for (int i = 0; i < StageCount; ++i) {
+        stage_json[stage_name(Stage(i))] = stages[i].to_json();
+    }
+
+    QJsonObject json;
+    json["elapsed_msec"] = elapsed_msec();
+    json["counters"] = counter_json;
+    json["index_cache_hit_ratio"] = cache_hit_ratio();
+    json["stages"] = stage_json;
+    return json;
+}
+
+QString ScanMetrics::summary() const {
+    QString text;
+    text += QString("Elapsed: %1 ms\n").arg(elapsed_msec());
+    for (int i = 0; i < CounterCount; ++i) {
+        text += QString("%1: %2\n").arg(counter_name(Counter(i))).arg(value(Counter(i)));
+    }
+    text += QString("index_cache_hit_ratio: %1%\n").arg(cache_hit_ratio() * 100.0, 0, 'f', 1);
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram &stage = stages[i];
+        text += QString("%1: %2 calls, %3 ms total, p50 %4 us, p99 %5 us, max %6 us\n")
+                    .arg(stage_name(Stage(i)))
+                    .arg(stage.count())
+                    .arg(stage.total_usec() / 1000)
+                    .arg(stage.percentile_usec(0.50))
+                    .arg(stage.percentile_usec(0.99))
+                    .arg(stage.max_usec());
+    }
+    return text;
+}
+
+QString ScanMetrics::counter_name(Counter counter) {
+    switch (counter) {
+        case PaksScanned: return "paks_scanned";
+        case BytesMapped: return "bytes_mapped";
+        case BytesRead: return "bytes_read";
+        case EntriesDecompressed: return "entries_decompressed";
+        case IndexCacheHits: return "index_cache_hits";
+        case IndexCacheMisses: return "index_cache_misses";
+        case DivineLaunches: return "divine_launches";
+        case TempBytesWritten: return "temp_bytes_written";
+        default: return "unknown";
+    }
+}
+
+QString ScanMetrics::stage_name(Stage stage) {
+    switch (stage) {
+        case StageDiscover: return "discover";
+        case StageIndex: return "index";
+        case StageExtract: return "extract";
+        case StageParse: return "parse";
+        case StageCleanup: return "cleanup";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SCANMETRICS_H
+#define SCANMETRICS_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+
+// Log2-bucketed latency histogram, safe to record into from any thread.
+class LatencyHistogram {
+public:
+    static constexpr int bucket_count = 32;
+
+    LatencyHistogram();
+    void record(qint64 usec);
+    void reset();
+
+    qint64 count() const;
+    qint64 total_usec() const;
+    qint64 max_usec() const;
+    qint64 percentile_usec(double percentile) const;
+    QJsonObject to_json() const;
+
+private:
+    QAtomicInteger<qint64> buckets[bucket_count];
+    QAtomicInteger<qint64> samples;
+    QAtomicInteger<qint64> total;
+    QAtomicInteger<qint64> maximum;
+};
+
+// Counters and per-stage latencies for a single scan.
+class ScanMetrics {
+public:
+    enum Counter {
+        PaksScanned,
+        BytesMapped,
+        BytesRead,
+        EntriesDecompressed,
+        IndexCacheHits,
+        IndexCacheMisses,
+        DivineLaunches,
+        TempBytesWritten,
+        CounterCount
+    };
+
+    enum Stage {
+        StageDiscover,
+        StageIndex,
+        StageExtract,
+        StageParse,
+        StageCleanup,
+        StageCount
+    };
+
+    // Records the lifetime of the object into the given stage.
+    class StageTimer {
+    public:
+        StageTimer(ScanMetrics &metrics, Stage stage);
+        ~StageTimer();
+
+    private:
+        ScanMetrics &metrics;
+        Stage stage;
+        QElapsedTimer timer;
+    };
+
+    ScanMetrics();
+    void add(Counter counter, qint64 amount = 1);
+    void record(Stage stage, qint64 usec);
+    void reset();
+
+    qint64 value(Counter counter) const;
+    double cache_hit_ratio() const;
+    qint64 elapsed_msec() const;
+    QJsonObject to_json() const;
+    QString summary() const;
+
+    static QString counter_name(Counter counter);
+    static QString stage_name(Stage stage);
+
+private:
+    QAtomicInteger<qint64> counters[CounterCount];
+    LatencyHistogram stages[StageCount];
+    QElapsedTimer scan_timer;
+};
+
+#endif
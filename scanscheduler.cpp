@@ -0,0 +1,169 @@
+#include "scanscheduler.h"
+#include <QMutexLocker>
+
+void ScanScheduler::reset(const QStringList &jobs, const QHash<QString, QStringList> &dependencies) {
+    QMutexLocker locker(&mutex);
+    for (QQueue<QString> &queue : queues) {
+        queue.clear();
+    }
+    priority_of.clear();
+    visible.clear();
+    waiting_on.clear();
+    dependents.clear();
+    depends_on.clear();
+    in_flight = 0;
+
+    QStringList unique_jobs;
+    for (const QString &job : jobs) {
+        if (!priority_of.contains(job)) {
+            priority_of.insert(job, Background);
+            unique_jobs << job;
+        }
+    }
+    // Only dependencies that are scanned in this run hold a job back
+    for (auto it = dependencies.begin(); it != dependencies.end(); ++it) {
+        if (!priority_of.contains(it.key())) {
+            continue;
+        }
+        for (const QString &dependency : it.value()) {
+            if (dependency != it.key() && priority_of.contains(dependency)) {
+                dependents[dependency] << it.key();
+                depends_on[it.key()] << dependency;
+                waiting_on[it.key()]++;
+            }
+        }
+    }
+    for (const QString &job : unique_jobs) {
+        if (!waiting_on.contains(job)) {
+            queues[Background].enqueue(job);
+        }
+    }
+    job_ready.wakeAll();
+}
+
+void ScanScheduler::clear() {
+    reset(QStringList());
+}
+
+void ScanScheduler::enqueue(const QString &job, Priority priority) {
+    if (priority == Selected) {
+        queues[priority].prepend(job);  // Latest click goes first
+    } else {
+        queues[priority].enqueue(job);
+    }
+}
+
+void ScanScheduler::release(const QString &job) {
+    // A blocked job's background slot is enqueued only now; a promoted job
+    // also goes into the queue of its priority.
+    int priority = priority_of.value(job, Background);
+    queues[Background].enqueue(job);
+    if (priority != Background) {
+        enqueue(job, Priority(priority));
+    }
+}
+
+void ScanScheduler::prioritize_blocked(const QString &job, Priority priority) {
+    // Promoting a blocked job is pointless unless what it waits for moves too
+    for (const QString &dependency : depends_on.value(job)) {
+        auto it = priority_of.find(dependency);
+        if (it == priority_of.end() || it.value() >= priority) {
+            continue;
+        }
+        it.value() = priority;
+        if (waiting_on.contains(dependency)) {
+            prioritize_blocked(dependency, priority);
+        } else {
+            enqueue(dependency, priority);
+        }
+    }
+}
+
+void ScanScheduler::prioritize(const QStringList &jobs, Priority priority) {
+    QMutexLocker locker(&mutex);
+    // Iterate backwards so that prepending to the selected queue keeps the
+    // caller's order at the front.
+    for (int i = jobs.size() - 1; i >= 0; --i) {
+        const QString &job = jobs[i];
+        auto it = priority_of.find(job);
+        if (it == priority_of.end() || it.value() > priority) {
+            continue;  // Already scanned or already more urgent
+        }
+        it.value() = priority;
+        if (waiting_on.contains(job)) {
+            prioritize_blocked(job, priority);  // Queued once it is released
+        } else {
+            enqueue(job, priority);
+        }
+    }
+}
+
+void ScanScheduler::set_visible(const QStringList &jobs) {
+    {
+        QMutexLocker locker(&mutex);
+        // Mods that scrolled out of view fall back to their original slot in the
+        // background queue, which is still there.
+        for (const QString &job : visible) {
+            auto it = priority_of.find(job);
+            if (it != priority_of.end() && it.value() == Visible) {
+                it.value() = Background;
+            }
+        }
+        visible = jobs;
+    }
+    prioritize(jobs, Visible);
+}
+
+bool ScanScheduler::take(QString &job) {
+    QMutexLocker locker(&mutex);
+    while (true) {
+        for (int priority = PriorityCount - 1; priority >= 0; --priority) {
+            QQueue<QString> &queue = queues[priority];
+            while (!queue.isEmpty()) {
+                QString candidate = queue.dequeue();
+                auto it = priority_of.find(candidate);
+                if (it != priority_of.end() && it.value() == priority && !waiting_on.contains(candidate)) {
+                    priority_of.erase(it);
+                    in_flight++;
+                    job = candidate;
+                    return true;
+                }
+            }
+        }
+        if (waiting_on.isEmpty()) {
+            return false;
+        }
+        if (in_flight == 0) {
+            // Nothing left that could release the blocked jobs, e.g. a worker
+            // never reported a dependency as finished; let them run anyway.
+            QStringList blocked = waiting_on.keys();
+            waiting_on.clear();
+            for (const QString &blocked_job : blocked) {
+                release(blocked_job);
+            }
+            continue;
+        }
+        job_ready.wait(&mutex);
+    }
+}
+
+void ScanScheduler::finish(const QString &job) {
+    QMutexLocker locker(&mutex);
+    if (in_flight > 0) {
+        in_flight--;
+    }
+    for (const QString &dependent : dependents.take(job)) {
+        auto it = waiting_on.find(dependent);
+        if (it == waiting_on.end() || --it.value() > 0) {
+            continue;
+        }
+        waiting_on.erase(it);
+        release(dependent);
+    }
+    job_ready.wakeAll();
+}
+
+int ScanScheduler::pending() const {
+    QMutexLocker locker(&mutex);
+    return priority_of.size();
+}
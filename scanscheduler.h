@@ -0,0 +1,50 @@
+#ifndef SCANSCHEDULER_H
+#define SCANSCHEDULER_H
+
+#include <QString>
+#include <QStringList>
+#include <QQueue>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+// Priority queue of mod folders waiting to be scanned. Jobs can be promoted
+// while the scan is running; queue entries are invalidated lazily, so moving a
+// job between priorities never has to search the queues. A job with
+// dependencies is held back until each of them has been finished.
+class ScanScheduler {
+public:
+    enum Priority {
+        Background,
+        Visible,
+        Selected,
+        PriorityCount
+    };
+
+    // dependencies maps a job to the jobs it has to wait for; it must be acyclic.
+    void reset(const QStringList &jobs, const QHash<QString, QStringList> &dependencies = {});
+    void clear();
+    void prioritize(const QStringList &jobs, Priority priority);
+    void set_visible(const QStringList &jobs);
+    // Blocks while every remaining job waits on one that is being scanned.
+    bool take(QString &job);
+    void finish(const QString &job);
+    int pending() const;
+
+private:
+    void enqueue(const QString &job, Priority priority);
+    void release(const QString &job);
+    void prioritize_blocked(const QString &job, Priority priority);
+
+    mutable QMutex mutex;
+    QQueue<QString> queues[PriorityCount];
+    QHash<QString, int> priority_of;
+    QStringList visible;
+    QHash<QString, int> waiting_on;  // blocked jobs -> unfinished dependencies
+    QHash<QString, QStringList> dependents;
+    QHash<QString, QStringList> depends_on;
+    int in_flight = 0;
+    QWaitCondition job_ready;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "scratchpool.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+ScratchPool::Lease::Lease(ScratchPool &pool, const QString &path) : pool(pool), dir(path) {
+}
+
+ScratchPool::Lease::~Lease() {
+    pool.release(dir);
+}
+
+QString ScratchPool::Lease::path() const {
+    return dir;
+}
+
+ScratchPool::ScratchPool() : next_id(0), recycle_dirs(true) {
+}
+
+void ScratchPool::reset(const QString &root, int prewarm) {
+    QMutexLocker locker(&mutex);
+    // Every scan gets a fresh subdirectory: retained output of an earlier scan
+    // must never show up in the directories handed out now.
+    qint64 stamp = QDateTime::currentMSecsSinceEpoch();
+    do {
+        root_path = root + "/" + QString::number(stamp++);
+    } while (QFileInfo::exists(root_path));
+    free_dirs.clear();
+    next_id = 0;
+    QDir().mkpath(root_path);
+    for (int i = 0; i < prewarm; ++i) {
+        free_dirs << create_locked();
+    }
+}
+
+void ScratchPool::set_recycle(bool recycle) {
+    QMutexLocker locker(&mutex);
+    recycle_dirs = recycle;
+}
+
+QString ScratchPool::create_locked() {
+    QString dir = root_path + "/" + QString::number(next_id++);
+    QDir().mkpath(dir);
+    return dir;
+}
+
+QString ScratchPool::acquire() {
+    QMutexLocker locker(&mutex);
+    if (!free_dirs.isEmpty()) {
+        return free_dirs.takeLast();
+    }
+    return create_locked();
+}
+
+void ScratchPool::release(const QString &dir) {
+    bool recycle;
+    {
+        QMutexLocker locker(&mutex);
+        recycle = recycle_dirs && dir.startsWith(root_path + "/");
+    }
+    if (!recycle) {
+        return;  // Kept for inspection, or left over from a previous scan
+    }
+
+    // Empty the directory on the releasing worker so the cost is spread over
+    // the scan rather than paid at the end.
+    empty_dir(dir);
+
+    QMutexLocker locker(&mutex);
+    free_dirs << dir;
+}
+
+int ScratchPool::created_count() const {
+    QMutexLocker locker(&mutex);
+    return next_id;
+}
+
+void ScratchPool::empty_dir(const QString &dir) {
+    QDir directory(dir);
+    for (const QFileInfo &entry : directory.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot)) {
+        if (entry.isDir() && !entry.isSymLink()) {
+            QDir(entry.absoluteFilePath()).removeRecursively();
+        } else {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef SCRATCHPOOL_H
+#define SCRATCHPOOL_H
+
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+
+// Hands out private, pre-created extraction directories to scan workers and
+// takes them back once a pak is done. Returned directories are emptied and
+// reused, so a scan creates roughly one directory per worker instead of one
+// per pak, and two paks with the same file name never share a directory.
+class ScratchPool {
+public:
+    class Lease {
+    public:
+        Lease(ScratchPool &pool, const QString &path);
+        ~Lease();
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        QString path() const;
+
+    private:
+        ScratchPool &pool;
+        QString dir;
+    };
+
+    ScratchPool();
+    // Starts a scan with prewarm directories in a new subdirectory of root.
+    void reset(const QString &root, int prewarm);
+    void set_recycle(bool recycle);
+    QString acquire();
+    void release(const QString &dir);
+    int created_count() const;
+
+private:
+    QString create_locked();
+    static void empty_dir(const QString &dir);
+
+    mutable QMutex mutex;
+    QString root_path;
+    QStringList free_dirs;
+    int next_id;
+    bool recycle_dirs;
+};
+
+#endif
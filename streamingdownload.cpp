@@ -0,0 +1,179 @@
+#include "streamingdownload.h"
+#include <QFileInfo>
+#include <QDir>
+
+StreamingDownload::StreamingDownload(QNetworkAccessManager *manager, const QUrl &url, const QString &destination, QObject *parent)
+    : QObject(parent), network_manager(manager), reply(nullptr), url(url), destination_path(destination),
+      part_path(destination + ".part"), hash(QCryptographicHash::Sha256), resume_offset(0), output_ready(false) {
+    buffer.resize(buffer_size);
+}
+
+void StreamingDownload::set_expected_sha256(const QByteArray &hex_digest) {
+    expected_sha256 = hex_digest.toLower();
+}
+
+QString StreamingDownload::destination() const {
+    return destination_path;
+}
+
+QByteArray StreamingDownload::sha256() const {
+    return digest;
+}
+
+void StreamingDownload::start() {
+    QDir().mkpath(QFileInfo(destination_path).absolutePath());
+    hash.reset();
+    output_ready = false;
+
+    // Re-hash whatever an interrupted run left behind so the final digest
+    // covers the whole file without holding it in memory.
+    resume_offset = 0;
+    QFile partial(part_path);
+    if (partial.open(QIODevice::ReadOnly)) {
+        while (!partial.atEnd()) {
+            qint64 read = partial.read(buffer.data(), buffer.size());
+            if (read <= 0) {
+                break;
+            }
+            hash.addData(QByteArrayView(buffer.constData(), read));
+            resume_offset += read;
+        }
+    }
+
+    QNetworkRequest request(url);
+    if (resume_offset > 0) {
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(resume_offset) + "-");
+    }
+
+    reply = network_manager->get(request);
+    // Bounds how much Qt buffers internally before we drain it to disk.
+    reply->setReadBufferSize(buffer_size);
+    connect(reply, &QNetworkReply::readyRead, this, &StreamingDownload::on_ready_read);
+    connect(reply, &QNetworkReply::downloadProgress, this, &StreamingDownload::on_download_progress);
+    connect(reply, &QNetworkReply::finished, this, &StreamingDownload::on_finished);
+}
+
+void StreamingDownload::abort() {
+    if (reply) {
+        reply->abort();
+    }
+}
+
+bool StreamingDownload::prepare_output() {
+    if (output_ready) {
+        return true;
+    }
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Append;
+    if (resume_offset > 0 && status != 206) {
+        // Server ignored the range request, start over.
+        resume_offset = 0;
+        hash.reset();
+        mode = QIODevice::WriteOnly | QIODevice::Truncate;
+    }
+
+    file.setFileName(part_path);
+    if (!file.open(mode)) {
+        return false;
+    }
+    output_ready = true;
+    return true;
+}
+
+bool StreamingDownload::write_available() {
+    while (reply->bytesAvailable() > 0) {
+        qint64 read = reply->read(buffer.data(), buffer.size());
+        if (read <= 0) {
+            break;
+        }
+        if (file.write(buffer.constData(), read) != read) {
+            return false;
+        }
+        hash.addData(QByteArrayView(buffer.constData(), read));
+    }
+    return true;
+}
+
+bool StreamingDownload::is_file_data() const {
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return status == 200 || (status == 206 && resume_offset > 0);
+}
+
+void StreamingDownload::on_ready_read() {
+    if (!is_file_data()) {
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status == 416 && resume_offset > 0) {
+            reply->readAll();  // Nothing left to fetch, on_finished takes the .part file as is
+            return;
+        }
+        // Never let an error page into the .part file, a resume would append to it
+        fail(QString("Error downloading %1: HTTP status %2").arg(url.toString()).arg(status));
+        return;
+    }
+    if (!prepare_output()) {
+        fail("Unable to open " + part_path + " for writing");
+        return;
+    }
+    if (!write_available()) {
+        fail("Error writing " + part_path + ": " + file.errorString());
+    }
+}
+
+void StreamingDownload::on_download_progress(qint64 bytes_received, qint64 bytes_total) {
+    emit progress(resume_offset + bytes_received, bytes_total < 0 ? -1 : resume_offset + bytes_total);
+}
+
+void StreamingDownload::on_finished() {
+    if (!reply) {
+        return;
+    }
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    bool already_complete = resume_offset > 0 && status == 416;  // The .part file already holds everything
+    if (reply->error() != QNetworkReply::NoError && !already_complete) {
+        // Keep the .part file so the next attempt can resume.
+        fail("Error downloading " + url.toString() + ": " + reply->errorString());
+        return;
+    }
+
+    if (!already_complete) {
+        if (!is_file_data()) {
+            fail(QString("Error downloading %1: HTTP status %2").arg(url.toString()).arg(status));
+            return;
+        }
+        if (!prepare_output() || !write_available()) {
+            fail("Error writing " + part_path + ": " + file.errorString());
+            return;
+        }
+    }
+    file.close();
+    reply->deleteLater();
+    reply = nullptr;
+
+    digest = hash.result().toHex();
+    if (!expected_sha256.isEmpty() && digest != expected_sha256) {
+        QFile::remove(part_path);
+        emit finished(false, "Checksum mismatch for " + url.toString() + ": expected "
+                                 + QString::fromLatin1(expected_sha256) + ", got " + QString::fromLatin1(digest));
+        return;
+    }
+
+    QFile::remove(destination_path);
+    if (!QFile::rename(part_path, destination_path)) {
+        emit finished(false, "Unable to move " + part_path + " to " + destination_path);
+        return;
+    }
+    emit finished(true, QString());
+}
+
+void StreamingDownload::fail(const QString &error) {
+    file.close();
+    if (reply) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+        reply = nullptr;
+    }
+    emit finished(false, error);
+}
@@ -0,0 +1,58 @@
+#ifndef STREAMINGDOWNLOAD_H
+#define STREAMINGDOWNLOAD_H
+
+#include <QObject>
+#include <QUrl>
+#include <QFile>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// Downloads a URL straight to disk through a fixed-size buffer. Data goes to
+// "<destination>.part" and is hashed as it arrives; an existing .part file is
+// resumed with an HTTP range request. The .part file is renamed to the
+// destination only after the checksum (if one is expected) matches.
+class StreamingDownload : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr qint64 buffer_size = 256 * 1024;
+
+    StreamingDownload(QNetworkAccessManager *manager, const QUrl &url, const QString &destination, QObject *parent = nullptr);
+    void set_expected_sha256(const QByteArray &hex_digest);
+    void start();
+    void abort();
+
+    QString destination() const;
+    QByteArray sha256() const;
+
+signals:
+    void progress(qint64 bytes_received, qint64 bytes_total);
+    void finished(bool success, const QString &error);
+
+private:
+    void on_ready_read();
+    void on_download_progress(qint64 bytes_received, qint64 bytes_total);
+    void on_finished();
+    // 200, or 206 for a range request; anything else is not part of the file.
+    bool is_file_data() const;
+    bool prepare_output();
+    bool write_available();
+    void fail(const QString &error);
+
+    QNetworkAccessManager *network_manager;
+    QNetworkReply *reply;
+    QUrl url;
+    QString destination_path;
+    QString part_path;
+    QFile file;
+    QCryptographicHash hash;
+    QByteArray buffer;
+    QByteArray expected_sha256;
+    QByteArray digest;
+    qint64 resume_offset;
+    bool output_ready;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "tempcleaner.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStorageInfo>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+
+static const char *trash_prefix = ".trash-";
+static const int batch_size = 512;
+
+TempCleaner::TempCleaner(QObject *parent) : QObject(parent) {
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(1);
+}
+
+TempCleaner::~TempCleaner() {
+    // Leftovers are picked up by sweep() on the next start.
+    stopping.storeRelease(1);
+    pool->waitForDone();
+}
+
+bool TempCleaner::schedule(const QString &dir) {
+    QFileInfo info(dir);
+    if (!info.exists()) {
+        return true;
+    }
+
+    static QAtomicInt sequence;
+    QString trash = info.absolutePath() + "/" + trash_prefix + info.fileName() + "-"
+                    + QString::number(QDateTime::currentMSecsSinceEpoch()) + "-" + QString::number(sequence.fetchAndAddRelaxed(1));
+    if (!QDir().rename(info.absoluteFilePath(), trash)) {
+        return false;
+    }
+
+    pool->start([this, trash]() {
+        remove_tree(trash);
+    });
+    return true;
+}
+
+void TempCleaner::sweep(const QString &parent_dir) {
+    // Trash queued once is already being removed; a second pass would race it
+    QDir dir(parent_dir);
+    if (swept_dirs.contains(dir.absolutePath())) {
+        return;
+    }
+    swept_dirs.insert(dir.absolutePath());
+    for (const QString &entry : dir.entryList(QStringList() << QString(trash_prefix) + "*", QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot)) {
+        QString trash = dir.filePath(entry);
+        pool->start([this, trash]() {
+            remove_tree(trash);
+        });
+    }
+}
+
+void TempCleaner::wait() {
+    pool->waitForDone();
+}
+
+void TempCleaner::remove_tree(const QString &dir) {
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+    qint64 removed = 0;
+    bool success = true;
+    QStringList directories;
+    QStringList batch;
+    batch.reserve(batch_size);
+
+    auto flush = [&]() {
+        for (const QString &file : batch) {
+            if (QFile::remove(file)) {
+                removed++;
+            } else {
+                success = false;
+            }
+        }
+        batch.clear();
+        // Give scan workers the disk between batches
+        QThread::yieldCurrentThread();
+    };
+
+    QDirIterator it(dir, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext() && !stopping.loadAcquire()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        if (info.isDir() && !info.isSymLink()) {
+            directories << info.absoluteFilePath();
+        } else {
+            batch << info.absoluteFilePath();
+            if (batch.size() >= batch_size) {
+                flush();
+            }
+        }
+    }
+    flush();
+
+    if (!stopping.loadAcquire()) {
+        // Deepest directories first
+        std::sort(directories.begin(), directories.end(), [](const QString &a, const QString &b) {
+            return a.size() > b.size();
+        });
+        for (const QString &directory : directories) {
+            success = QDir().rmdir(directory) && success;
+        }
+        // Already gone counts as removed
+        success = (QDir().rmdir(dir) || !QFileInfo::exists(dir)) && success;
+    }
+
+    emit cleanup_finished(dir, removed, success && !stopping.loadAcquire());
+}
+
+QString TempCleaner::tmpfs_root(qint64 min_free_bytes) {
+#ifdef Q_OS_LINUX
+    QStorageInfo storage("/dev/shm");
+    if (storage.isValid() && storage.fileSystemType() == "tmpfs" && !storage.isReadOnly()
+        && storage.bytesAvailable() >= min_free_bytes) {
+        QString root = "/dev/shm/DefakofModdingTools-" + qEnvironmentVariable("USER", "user");
+        if (QDir().mkpath(root)) {
+            return root;
+        }
+    }
+#else
+    Q_UNUSED(min_free_bytes);
+#endif
+    return QString();
+}
@@ -0,0 +1,44 @@
+#ifndef TEMPCLEANER_H
+#define TEMPCLEANER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+// Deletes scan output off the calling thread. A directory is first renamed
+// aside (cheap and atomic on the same volume), so a new scan can reuse the
+// original path immediately, then removed in batches on a low priority thread.
+class TempCleaner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TempCleaner(QObject *parent = nullptr);
+    ~TempCleaner() override;
+
+    // Returns false if the directory could not be moved aside.
+    bool schedule(const QString &dir);
+
+    // Removes trash left behind by a run that exited mid-cleanup. Each parent
+    // directory is swept once per run.
+    void sweep(const QString &parent_dir);
+    void wait();
+
+    // A writable tmpfs-backed directory for scan output, or an empty string
+    // when the platform has none (or too little free space).
+    static QString tmpfs_root(qint64 min_free_bytes);
+
+signals:
+    void cleanup_finished(const QString &dir, qint64 files_removed, bool success);
+
+private:
+    void remove_tree(const QString &dir);
+
+    QThreadPool *pool;
+    QAtomicInt stopping;
+    QSet<QString> swept_dirs;
+};
+
+#endif
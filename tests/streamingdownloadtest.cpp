@@ -0,0 +1,214 @@
+#include "streamingdownload.h"
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+
+// Minimal HTTP/1.1 stand-in: serves one body, optionally honouring ranges,
+// or answers every request with a fixed error status.
+class HttpStandIn : public QObject {
+    Q_OBJECT
+
+public:
+    QByteArray content;
+    bool honour_range = true;
+    int error_status = 0;
+    QByteArrayList range_headers;
+
+    HttpStandIn() {
+        connect(&server, &QTcpServer::newConnection, this, &HttpStandIn::on_connection);
+        server.listen(QHostAddress::LocalHost);
+    }
+
+    QUrl url() const {
+        return QUrl(QString("http://127.0.0.1:%1/ExportTool.zip").arg(server.serverPort()));
+    }
+
+private:
+    void on_connection() {
+        while (QTcpSocket *socket = server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+                QByteArray &request = pending[socket];
+                request += socket->readAll();
+                if (request.contains("\r\n\r\n")) {
+                    respond(socket, request);
+                }
+            });
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    }
+
+    void respond(QTcpSocket *socket, const QByteArray &request) {
+        qint64 offset = 0;
+        for (const QByteArray &line : request.split('\n')) {
+            if (line.toLower().startsWith("range:")) {
+                QByteArray value = line.mid(6).trimmed();
+                range_headers << value;
+                offset = value.mid(6, value.indexOf('-') - 6).toLongLong();  // "bytes=N-"
+            }
+        }
+
+        QByteArray status = "200 OK";
+        QByteArray body = content;
+        QByteArray extra;
+        if (error_status != 0) {
+            status = QByteArray::number(error_status) + " Error";
+            body = "<html>error page</html>";
+        } else if (offset > 0 && honour_range) {
+            if (offset >= content.size()) {
+                status = "416 Range Not Satisfiable";
+                body.clear();
+            } else {
+                status = "206 Partial Content";
+                body = content.mid(offset);
+                extra = "Content-Range: bytes " + QByteArray::number(offset) + "-" + QByteArray::number(content.size() - 1)
+                        + "/" + QByteArray::number(content.size()) + "\r\n";
+            }
+        }
+        socket->write("HTTP/1.1 " + status + "\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n" + extra
+                      + "Connection: close\r\n\r\n" + body);
+        socket->disconnectFromHost();
+        pending.remove(socket);
+    }
+
+    QTcpServer server;
+    QHash<QTcpSocket *, QByteArray> pending;
+};
+
+class StreamingDownloadTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void full_download();
+    void resumes_with_range_request();
+    void restarts_when_range_is_ignored();
+    void already_complete_part_file();
+    void checksum_mismatch_discards_part_file();
+    void error_status_keeps_part_file();
+
+private:
+    bool run(const QUrl &url, const QByteArray &sha256, QString *error = nullptr);
+    void write_part(const QByteArray &data);
+    QByteArray read(const QString &path);
+
+    QNetworkAccessManager manager;
+    QTemporaryDir dir;
+    QString destination;
+    QByteArray content;
+};
+
+void StreamingDownloadTest::init() {
+    destination = dir.filePath("download.zip");
+    QFile::remove(destination);
+    QFile::remove(destination + ".part");
+    content.clear();
+    for (int i = 0; i < 3 * StreamingDownload::buffer_size + 123; ++i) {
+        content += char(i * 31 + i / 7);
+    }
+}
+
+bool StreamingDownloadTest::run(const QUrl &url, const QByteArray &sha256, QString *error) {
+    StreamingDownload download(&manager, url, destination);
+    download.set_expected_sha256(sha256);
+    QSignalSpy finished(&download, &StreamingDownload::finished);
+    download.start();
+    if (!finished.wait(10000)) {
+        return false;
+    }
+    if (error) {
+        *error = finished.first().at(1).toString();
+    }
+    return finished.first().at(0).toBool();
+}
+
+void StreamingDownloadTest::write_part(const QByteArray &data) {
+    QFile part(destination + ".part");
+    QVERIFY(part.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    part.write(data);
+}
+
+QByteArray StreamingDownloadTest::read(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void StreamingDownloadTest::full_download() {
+    HttpStandIn server;
+    server.content = content;
+    QByteArray sha256 = QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex();
+
+    QVERIFY(run(server.url(), sha256));
+    QCOMPARE(read(destination), content);
+    QVERIFY(!QFile::exists(destination + ".part"));
+    QVERIFY(server.range_headers.isEmpty());
+}
+
+void StreamingDownloadTest::resumes_with_range_request() {
+    HttpStandIn server;
+    server.content = content;
+    qint64 offset = StreamingDownload::buffer_size + 17;
+    write_part(content.left(offset));
+    QByteArray sha256 = QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex();
+
+    QVERIFY(run(server.url(), sha256));
+    QCOMPARE(server.range_headers, QByteArrayList{"bytes=" + QByteArray::number(offset) + "-"});
+    QCOMPARE(read(destination), content);
+}
+
+void StreamingDownloadTest::restarts_when_range_is_ignored() {
+    HttpStandIn server;
+    server.content = content;
+    server.honour_range = false;
+    write_part(content.left(1000));
+    QByteArray sha256 = QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex();
+
+    QVERIFY(run(server.url(), sha256));
+    QCOMPARE(server.range_headers.size(), 1);
+    QCOMPARE(read(destination), content);
+}
+
+void StreamingDownloadTest::already_complete_part_file() {
+    HttpStandIn server;
+    server.content = content;
+    write_part(content);
+    QByteArray sha256 = QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex();
+
+    QVERIFY(run(server.url(), sha256));
+    QCOMPARE(read(destination), content);
+}
+
+void StreamingDownloadTest::checksum_mismatch_discards_part_file() {
+    HttpStandIn server;
+    server.content = content;
+    write_part(content.left(500));
+    QByteArray wrong = QCryptographicHash::hash("something else", QCryptographicHash::Sha256).toHex();
+
+    QString error;
+    QVERIFY(!run(server.url(), wrong, &error));
+    QVERIFY(error.contains("Checksum mismatch"));
+    QVERIFY(!QFile::exists(destination));
+    QVERIFY(!QFile::exists(destination + ".part"));
+}
+
+void StreamingDownloadTest::error_status_keeps_part_file() {
+    HttpStandIn server;
+    server.content = content;
+    server.error_status = 500;
+    write_part(content.left(500));
+
+    QString error;
+    QVERIFY(!run(server.url(), QByteArray(), &error));
+    QVERIFY(!QFile::exists(destination));
+    QCOMPARE(read(destination + ".part"), content.left(500));
+
+    // The next attempt resumes from the untouched .part file
+    server.error_status = 0;
+    QByteArray sha256 = QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex();
+    QVERIFY(run(server.url(), sha256));
+    QCOMPARE(server.range_headers.last(), QByteArray("bytes=500-"));
+    QCOMPARE(read(destination), content);
+}
+
+QTEST_MAIN(StreamingDownloadTest)
+#include "streamingdownloadtest.moc"
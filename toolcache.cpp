@@ -0,0 +1,161 @@
+#include "toolcache.h"
+#include "ziparchive.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVersionNumber>
+#include <algorithm>
+
+static const char *manifest_name = "manifest.json";
+
+ToolCache::ToolCache(const QString &root) : root_path(root) {
+}
+
+QString ToolCache::default_root() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/DefakofModdingTools/tools";
+}
+
+QString ToolCache::root() const {
+    return root_path;
+}
+
+QString ToolCache::download_path(const QString &version) const {
+    return root_path + "/downloads/ExportTool-v" + version + ".zip";
+}
+
+QString ToolCache::version_dir(const QString &version) const {
+    return root_path + "/versions/" + version;
+}
+
+QStringList ToolCache::installed_versions() const {
+    QStringList versions;
+    QDir dir(root_path + "/versions");
+    for (const QString &entry : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (!entry.startsWith('.') && QFile::exists(dir.filePath(entry) + "/" + manifest_name)) {
+            versions << entry;
+        }
+    }
+
+    // Newest first
+    std::sort(versions.begin(), versions.end(), [](const QString &a, const QString &b) {
+        return QVersionNumber::fromString(a) > QVersionNumber::fromString(b);
+    });
+    return versions;
+}
+
+QByteArray ToolCache::file_sha256(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(&file);
+    return hash.result().toHex();
+}
+
+QString ToolCache::divine_path(const QString &version) const {
+    QFile file(version_dir(version) + "/" + manifest_name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+    QString path = version_dir(version) + "/" + manifest["divine"].toString();
+    if (file_sha256(path) != manifest["divine_sha256"].toString().toLatin1()) {
+        return QString();
+    }
+    return path;
+}
+
+QString ToolCache::install(const QString &version, const QString &zip_path, const QByteArray &archive_sha256, QString &error) {
+    QDir().mkpath(root_path + "/objects");
+    QDir().mkpath(root_path + "/versions");
+
+    QByteArray sha256 = archive_sha256.isEmpty() ? file_sha256(zip_path) : archive_sha256;
+    QString object_path = root_path + "/objects/" + QString::fromLatin1(sha256) + ".zip";
+    if (QFile::exists(object_path)) {
+        QFile::remove(zip_path);
+    } else if (!QFile::rename(zip_path, object_path)) {
+        error = "Unable to move " + zip_path + " into the tool cache";
+        return QString();
+    }
+
+    QString installed = divine_path(version);
+    if (!installed.isEmpty()) {
+        return installed;  // Another instance got there first
+    }
+
+    ZipArchive archive(object_path);
+    if (!archive.open()) {
+        error = archive.error_string();
+        return QString();
+    }
+
+    // Only divine.exe and the libraries next to it are needed, the GUI tools
+    // and debug symbols in the archive are skipped.
+    QString divine_member;
+    for (const ZipArchive::Entry &entry : archive.entries()) {
+        if (QFileInfo(entry.name).fileName().compare("divine.exe", Qt::CaseInsensitive) == 0) {
+            divine_member = entry.name;
+            break;
+        }
+    }
+    if (divine_member.isEmpty()) {
+        error = "ExportTool zip does not contain divine.exe";
+        return QString();
+    }
+
+    QString prefix = divine_member.left(divine_member.size() - QFileInfo(divine_member).fileName().size());
+    QVector<ZipArchive::Entry> needed;
+    for (const ZipArchive::Entry &entry : archive.entries()) {
+        if (!entry.name.startsWith(prefix)) {
+            continue;
+        }
+        QString suffix = QFileInfo(entry.name).suffix().toLower();
+        if (entry.name == divine_member || (suffix != "exe" && suffix != "pdb" && suffix != "xml")) {
+            needed << entry;
+        }
+    }
+
+    QString staging = root_path + "/versions/." + version + "-" + QString::number(QCoreApplication::applicationPid());
+    QDir(staging).removeRecursively();
+    if (!archive.extract(needed, prefix, staging)) {
+        error = archive.error_string();
+        QDir(staging).removeRecursively();
+        return QString();
+    }
+
+    QString divine_name = divine_member.mid(prefix.size());
+    QJsonObject manifest;
+    manifest["version"] = version;
+    manifest["archive_sha256"] = QString::fromLatin1(sha256);
+    manifest["divine"] = divine_name;
+    manifest["divine_sha256"] = QString::fromLatin1(file_sha256(staging + "/" + divine_name));
+    manifest["files"] = needed.size();
+
+    QSaveFile manifest_file(staging + "/" + manifest_name);
+    if (!manifest_file.open(QIODevice::WriteOnly)) {
+        error = "Unable to write tool manifest";
+        QDir(staging).removeRecursively();
+        return QString();
+    }
+    manifest_file.write(QJsonDocument(manifest).toJson());
+    manifest_file.commit();
+
+    // Publish atomically; losing the race to another instance is fine.
+    if (!QDir().rename(staging, version_dir(version))) {
+        QDir(staging).removeRecursively();
+        installed = divine_path(version);
+        if (installed.isEmpty()) {
+            error = "Unable to install ExportTool " + version + " into " + version_dir(version);
+        }
+        return installed;
+    }
+    return version_dir(version) + "/" + divine_name;
+}
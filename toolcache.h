@@ -0,0 +1,37 @@
+#ifndef TOOLCACHE_H
+#define TOOLCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+// Per-machine cache of ExportTool releases, shared by the GUI and the CLI and
+// kept apart from the scan temp folder. Archives are stored by content hash
+// under objects/, each version is extracted once into versions/<version> via a
+// staging directory that is renamed into place, so readers never see a
+// half-installed tool.
+class ToolCache {
+public:
+    explicit ToolCache(const QString &root = default_root());
+    static QString default_root();
+
+    QString root() const;
+    QString download_path(const QString &version) const;
+    QStringList installed_versions() const;
+
+    // Path to divine.exe for an installed version, empty if the version is
+    // missing or its divine.exe no longer matches the recorded hash.
+    QString divine_path(const QString &version) const;
+
+    // Moves a downloaded archive into the cache and installs it. Returns the
+    // path to divine.exe or an empty string with error set.
+    QString install(const QString &version, const QString &zip_path, const QByteArray &archive_sha256, QString &error);
+
+private:
+    QString version_dir(const QString &version) const;
+    static QByteArray file_sha256(const QString &path);
+
+    QString root_path;
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include "translationdeployer.h"
+#include "lspkwriter.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+
+TranslationDeployer::TranslationDeployer(const LocaSnapshot &snapshot, const DuplicateStrings &duplicates,
+                                         const QString &source_language, const QString &target_language)
+    : snapshot(snapshot), duplicates(duplicates), source_language(source_language), target_language(target_language) {
+}
+
+QString TranslationDeployer::loca_path(const QString &mod_name) const {
+    static const QRegularExpression unsafe("[^A-Za-z0-9_.-]+");
+    QString file_name = QString(mod_name).replace(unsafe, "_");
+    if (file_name != mod_name) {
+        // "Foo Bar" and "Foo_Bar" must not end up in the same file
+        file_name += "_" + QString::fromLatin1(QCryptographicHash::hash(mod_name.toUtf8(), QCryptographicHash::Sha1).toHex().left(8));
+    }
+    return "Localization/" + target_language + "/" + file_name + ".loca";
+}
+
+QStringList TranslationDeployer::loca_paths(const QVector<ModInput> &mods) const {
+    // Paths inside a package compare case-insensitively in game
+    QStringList paths;
+    QSet<QString> used;
+    for (const ModInput &mod : mods) {
+        QString path = loca_path(mod.name);
+        QString unique = path;
+        for (int n = 2; used.contains(unique.toLower()); ++n) {
+            unique = path.chopped(5) + "_" + QString::number(n) + ".loca";
+        }
+        used.insert(unique.toLower());
+        paths << unique;
+    }
+    return paths;
+}
+
+QVector<LocalizationFile::Entry> TranslationDeployer::collect(const ModInput &mod) const {
+    QVector<LocalizationFile::Entry> translated;
+    QByteArray previous_key;
+    for (const LocalizationFile::Entry &entry : snapshot.strings(source_language, mod.sources)) {
+        // Several paks of one mod may carry the same key
+        if (entry.key == previous_key) {
+            continue;
+        }
+        previous_key = entry.key;
+
+        QString existing;
+        if (snapshot.lookup(target_language, entry.key, existing)) {
+            continue;
+        }
+        // Groups only share a hash, a collision must not ship someone else's line
+        int index = snapshot.index_of(source_language, entry.key);
+        for (int duplicate : duplicates.duplicates_of(index)) {
+            QByteArray duplicate_key;
+            QString text;
+            if (snapshot.entry(source_language, duplicate, &duplicate_key, nullptr)
+                && snapshot.lookup(target_language, duplicate_key, text) && duplicates.same_text(index, duplicate)) {
+                translated << LocalizationFile::Entry{entry.key, entry.version, text};
+                break;
+            }
+        }
+    }
+    return translated;
+}
+
+QStringList TranslationDeployer::game_languages() {
+    return {"English", "BrazilianPortuguese", "Chinese", "ChineseTraditional", "French", "German", "Italian",
+            "Japanese", "Korean", "LatinSpanish", "Polish", "Russian", "Spanish", "Turkish", "Ukrainian"};
+}
+
+QString TranslationDeployer::game_language(const QLocale &locale) {
+    switch (locale.language()) {
+        case QLocale::Chinese:
+            if (locale.script() == QLocale::TraditionalHanScript || locale.territory() == QLocale::Taiwan
+                || locale.territory() == QLocale::HongKong || locale.territory() == QLocale::Macao) {
+                return "ChineseTraditional";
+            }
+            return "Chinese";
+        case QLocale::Spanish:
+            return locale.territory() == QLocale::Spain ? "Spanish" : "LatinSpanish";
+        case QLocale::Portuguese:
+            return "BrazilianPortuguese";
+        case QLocale::French: return "French";
+        case QLocale::German: return "German";
+        case QLocale::Italian: return "Italian";
+        case QLocale::Japanese: return "Japanese";
+        case QLocale::Korean: return "Korean";
+        case QLocale::Polish: return "Polish";
+        case QLocale::Russian: return "Russian";
+        case QLocale::Turkish: return "Turkish";
+        case QLocale::Ukrainian: return "Ukrainian";
+        default: return "English";
+    }
+}
+
+QString TranslationDeployer::manifest_path(const QString &package_path) {
+    return package_path + ".manifest.json";
+}
+
+bool TranslationDeployer::deploy(const QVector<ModInput> &mods, const QString &package_path, Result &result, QString &error) const {
+    if (duplicates.snapshot().data() != &snapshot) {
+        error = "The duplicate index belongs to another localization snapshot";
+        return false;
+    }
+
+    // Collecting and encoding is cheap next to compression, so every .loca is
+    // rebuilt in memory and its hash decides whether the old bytes can stay.
+    QVector<QByteArray> locas(mods.size());
+    QVector<int> counts(mods.size());
+    QVector<QByteArray> hashes(mods.size());
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    for (int i = 0; i < mods.size(); ++i) {
+        pool.start([this, &mods, &locas, &counts, &hashes, i]() {
+            QVector<LocalizationFile::Entry> entries = collect(mods[i]);
+            counts[i] = int(entries.size());
+            if (!entries.isEmpty()) {
+                locas[i] = LocalizationFile::write_loca(entries);
+                hashes[i] = QCryptographicHash::hash(locas[i], QCryptographicHash::Sha1).toHex();
+            }
+        });
+    }
+    pool.waitForDone();
+
+    result = Result();
+    QStringList paths = loca_paths(mods);
+    QHash<QString, QByteArray> file_hashes;
+    for (int i = 0; i < mods.size(); ++i) {
+        if (!locas[i].isEmpty()) {
+            file_hashes.insert(paths[i], hashes[i]);
+            result.files++;
+            result.strings += counts[i];
+        }
+    }
+    if (result.files == 0) {
+        error = "Nothing to deploy for " + target_language;
+        return false;
+    }
+
+    // The previous build only counts if the package is exactly what the manifest describes
+    QHash<QString, QByteArray> previous_hashes;
+    QFileInfo package_info(package_path);
+    QFile manifest_file(manifest_path(package_path));
+    if (package_info.exists() && manifest_file.open(QIODevice::ReadOnly)) {
+        QJsonObject manifest = QJsonDocument::fromJson(manifest_file.readAll()).object();
+        if (manifest["package_size"].toInteger() == package_info.size()
+            && manifest["package_modified"].toInteger() == package_info.lastModified().toMSecsSinceEpoch()) {
+            QJsonObject files = manifest["files"].toObject();
+            for (auto it = files.begin(); it != files.end(); ++it) {
+                previous_hashes.insert(it.key(), it.value().toString().toLatin1());
+            }
+        }
+        manifest_file.close();
+    }
+    if (!previous_hashes.isEmpty() && previous_hashes == file_hashes) {
+        result.unchanged = true;
+        result.reused = result.files;
+        return true;
+    }
+
+    // Pull unchanged blobs out before the package is replaced
+    QHash<QString, LspkReader::Entry> reusable;
+    QHash<QString, QByteArray> reusable_data;
+    if (!previous_hashes.isEmpty()) {
+        LspkReader previous(package_path);
+        if (previous.open()) {
+            for (const LspkReader::Entry &entry : previous.entries()) {
+                if (file_hashes.contains(entry.name) && previous_hashes.value(entry.name) == file_hashes.value(entry.name)) {
+                    QByteArray raw = previous.read_raw(entry);
+                    if (!raw.isNull()) {
+                        reusable.insert(entry.name, entry);
+                        reusable_data.insert(entry.name, raw);
+                    }
+                }
+            }
+        }
+    }
+
+    LspkWriter writer(package_path);
+    for (int i = 0; i < mods.size(); ++i) {
+        if (locas[i].isEmpty()) {
+            continue;
+        }
+        const QString &name = paths[i];
+        auto reused = reusable.constFind(name);
+        if (reused != reusable.constEnd()) {
+            writer.add_compressed_file(name, reusable_data.value(name), reused->compression(), qint64(reused->uncompressed_size));
+            result.reused++;
+        } else {
+            writer.add_file(name, locas[i]);
+        }
+    }
+
+    if (!QDir().mkpath(package_info.absolutePath()) || !writer.write()) {
+        error = writer.error_string().isEmpty() ? "Unable to create " + package_info.absolutePath() : writer.error_string();
+        return false;
+    }
+
+    package_info.refresh();
+    QJsonObject files;
+    for (auto it = file_hashes.constBegin(); it != file_hashes.constEnd(); ++it) {
+        files[it.key()] = QString::fromLatin1(it.value());
+    }
+    QJsonObject manifest;
+    manifest["package_size"] = package_info.size();
+    manifest["package_modified"] = package_info.lastModified().toMSecsSinceEpoch();
+    manifest["files"] = files;
+    QSaveFile manifest_output(manifest_path(package_path));
+    if (!manifest_output.open(QIODevice::WriteOnly)) {
+        error = "Unable to write " + manifest_output.fileName();
+        return false;
+    }
+    manifest_output.write(QJsonDocument(manifest).toJson(QJsonDocument::Indented));
+    if (!manifest_output.commit()) {
+        error = "Unable to write " + manifest_output.fileName();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef TRANSLATIONDEPLOYER_H
+#define TRANSLATIONDEPLOYER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSet>
+#include <QByteArray>
+#include <QLocale>
+#include "locasnapshot.h"
+#include "duplicatestrings.h"
+#include "localizationfile.h"
+
+// Builds the translation mod for one target language: every untranslated
+// source string of the profile's mods that has an identical, already
+// translated line somewhere else, written as one .loca per source mod inside
+// a single package.
+//
+// Deploys are incremental. A manifest next to the package records the content
+// hash of each .loca; files whose hash is unchanged reuse their compressed
+// bytes from the previous package, and when nothing changed at all the
+// package is not rewritten.
+class TranslationDeployer {
+public:
+    struct ModInput {
+        QString name;
+        QSet<QByteArray> sources;  // pak fingerprints
+    };
+
+    struct Result {
+        int files = 0;
+        int strings = 0;
+        int reused = 0;  // files whose compressed data came from the previous build
+        bool unchanged = false;  // nothing changed, the package was left alone
+    };
+
+    TranslationDeployer(const LocaSnapshot &snapshot, const DuplicateStrings &duplicates,
+                        const QString &source_language, const QString &target_language);
+
+    QVector<LocalizationFile::Entry> collect(const ModInput &mod) const;
+    bool deploy(const QVector<ModInput> &mods, const QString &package_path, Result &result, QString &error) const;
+
+    QString loca_path(const QString &mod_name) const;
+    // loca_path for each mod, made unique within the package.
+    QStringList loca_paths(const QVector<ModInput> &mods) const;
+    static QString manifest_path(const QString &package_path);
+    // Localization folder names the game reads, English first.
+    static QStringList game_languages();
+    // Game language for a locale, English when the game has none for it.
+    static QString game_language(const QLocale &locale);
+
+private:
+    const LocaSnapshot &snapshot;
+    const DuplicateStrings &duplicates;
+    QString source_language;
+    QString target_language;
+};
+
+#endif
@@ -0,0 +1,314 @@
+#include "translationmemory.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+// Walking every posting list of a query would touch millions of ids for
+// common trigrams, so only the rarest lists generate candidates, up to a
+// budget of postings. The longer lists are probed per candidate instead, and
+// only the best candidates by shared trigrams reach the edit distance check.
+static const int max_walked_postings = 1 << 16;
+static const int max_probed_candidates = 1024;
+static const int max_verified_candidates = 256;
+static const char16_t boundary = u'\x02';
+
+namespace {
+
+// Myers/Hyyrö bit-parallel Levenshtein distance, 64 pattern characters per
+// block. The pattern bitmasks are built once per query and reused for every
+// candidate.
+class MyersPattern {
+public:
+    explicit MyersPattern(const char16_t *pattern, int length) : length(length) {
+        blocks = qMax(1, (length + 63) / 64);
+        // Slot 0 is for characters that do not occur in the pattern
+        peq.fill(0, blocks);
+        for (int i = 0; i < length; ++i) {
+            int slot = slot_for(pattern[i]);
+            if (slot == 0) {
+                slot = int(peq.size()) / blocks;
+                peq.resize(peq.size() + blocks, 0);
+                if (pattern[i] < 256) {
+                    latin1_slots[pattern[i]] = slot;
+                } else {
+                    other_slots.insert(pattern[i], slot);
+                }
+            }
+            peq[slot * blocks + i / 64] |= quint64(1) << (i % 64);
+        }
+        last_bit = length > 0 ? quint64(1) << ((length - 1) % 64) : 1;
+    }
+
+    int distance(const char16_t *text, int text_length) const {
+        if (length == 0) {
+            return text_length;
+        }
+
+        QVarLengthArray<quint64, 8> pv(blocks);
+        QVarLengthArray<quint64, 8> mv(blocks);
+        for (int b = 0; b < blocks; ++b) {
+            pv[b] = ~quint64(0);
+            mv[b] = 0;
+        }
+
+        int score = length;
+        for (int j = 0; j < text_length; ++j) {
+            const quint64 *eq = peq.constData() + slot_for(text[j]) * blocks;
+            int carry = 1;  // global alignment: the top row grows by one per column
+            for (int b = 0; b < blocks; ++b) {
+                quint64 high_bit = b == blocks - 1 ? last_bit : quint64(1) << 63;
+                carry = advance(pv[b], mv[b], eq[b], carry, high_bit);
+            }
+            score += carry;
+        }
+        return score;
+    }
+
+private:
+    static int advance(quint64 &pv, quint64 &mv, quint64 eq, int hin, quint64 high_bit) {
+        quint64 xv = eq | mv;
+        if (hin < 0) {
+            eq |= 1;
+        }
+        quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+
+        int hout = 0;
+        if (ph & high_bit) {
+            hout = 1;
+        } else if (mh & high_bit) {
+            hout = -1;
+        }
+
+        ph <<= 1;
+        mh <<= 1;
+        if (hin < 0) {
+            mh |= 1;
+        } else if (hin > 0) {
+            ph |= 1;
+        }
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        return hout;
+    }
+
+    int slot_for(char16_t c) const {
+        return c < 256 ? latin1_slots[c] : other_slots.value(c, 0);
+    }
+
+    int length;
+    int blocks;
+    quint64 last_bit;
+    QVector<quint64> peq;
+    int latin1_slots[256] = {};
+    QHash<char16_t, int> other_slots;
+};
+
+}
+
+TranslationMemory::TranslationMemory() {
+}
+
+void TranslationMemory::clear() {
+    sources.clear();
+    targets.clear();
+    source_lengths.clear();
+    seen_pairs.clear();
+    grams.clear();
+    offsets.clear();
+    postings.clear();
+}
+
+void TranslationMemory::build(const LocaSnapshot &snapshot, const QString &source_language, const QString &target_language) {
+    clear();
+    snapshot.for_each_pair(source_language, target_language, [this](QByteArrayView, QByteArrayView source, QByteArrayView target) {
+        add(QString::fromUtf8(source), QString::fromUtf8(target));
+    });
+    finalize();
+}
+
+void TranslationMemory::add(const QString &source, const QString &target) {
+    if (source.trimmed().isEmpty() || target.trimmed().isEmpty() || source == target) {
+        return;  // untranslated copies are no use as suggestions
+    }
+    QPair<QString, QString> pair(source, target);
+    if (seen_pairs.contains(pair)) {
+        return;
+    }
+    seen_pairs.insert(pair);
+    sources << source;
+    targets << target;
+}
+
+int TranslationMemory::size() const {
+    return int(sources.size());
+}
+
+QString TranslationMemory::normalize(const QString &text) {
+    return text.simplified().toCaseFolded();
+}
+
+void TranslationMemory::trigrams(const QString &normalized, QVector<quint64> &result) {
+    result.clear();
+    QString padded = QString(2, QChar(boundary)) + normalized + QString(2, QChar(boundary));
+    const char16_t *p = reinterpret_cast<const char16_t *>(padded.utf16());
+    for (qsizetype i = 0; i + 2 < padded.size(); ++i) {
+        result << ((quint64(p[i]) << 32) | (quint64(p[i + 1]) << 16) | quint64(p[i + 2]));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+void TranslationMemory::finalize() {
+    seen_pairs.clear();
+    source_lengths.resize(sources.size());
+
+    QVector<QPair<quint64, quint32>> pairs;
+    QVector<quint64> entry_grams;
+    for (int id = 0; id < sources.size(); ++id) {
+        QString normalized = normalize(sources[id]);
+        source_lengths[id] = int(normalized.size());
+        trigrams(normalized, entry_grams);
+        for (quint64 gram : entry_grams) {
+            pairs << qMakePair(gram, quint32(id));
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    grams.clear();
+    offsets.clear();
+    postings.clear();
+    postings.reserve(pairs.size());
+    for (const auto &pair : pairs) {
+        if (grams.isEmpty() || grams.last() != pair.first) {
+            grams << pair.first;
+            offsets << quint32(postings.size());
+        }
+        postings << pair.second;
+    }
+    offsets << quint32(postings.size());
+}
+
+QVector<TranslationMemory::Suggestion> TranslationMemory::lookup(const QString &text, int max_results, double min_similarity) const {
+    QVector<Suggestion> suggestions;
+    QString query = normalize(text);
+    int query_length = int(query.size());
+    if (query_length == 0 || sources.isEmpty()) {
+        return suggestions;
+    }
+    min_similarity = qBound(0.01, min_similarity, 1.0);
+
+    // Posting ranges of the query's trigrams, rarest first
+    QVector<quint64> query_grams;
+    trigrams(query, query_grams);
+    QVector<QPair<quint32, quint32>> ranges;
+    for (quint64 gram : query_grams) {
+        auto it = std::lower_bound(grams.constBegin(), grams.constEnd(), gram);
+        if (it != grams.constEnd() && *it == gram) {
+            int index = int(it - grams.constBegin());
+            ranges << qMakePair(offsets[index], offsets[index + 1]);
+        }
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const QPair<quint32, quint32> &a, const QPair<quint32, quint32> &b) {
+        return a.second - a.first < b.second - b.first;
+    });
+
+    // A match within k edits keeps all but at most 3k of the query's trigrams
+    // (count filter), so it must appear in one of the 3k + 1 rarest lists.
+    int max_length = int(query_length / min_similarity);
+    int max_edits = int((1.0 - min_similarity) * max_length);
+    int query_gram_count = int(query_grams.size());
+    int threshold = query_gram_count - 3 * max_edits;
+    int needed = threshold > 0 ? qMin(int(ranges.size()), query_gram_count - threshold + 1) : int(ranges.size());
+    int generating = 0;
+    qint64 walked = 0;
+    while (generating < needed && (generating == 0 || walked + ranges[generating].second - ranges[generating].first <= max_walked_postings)) {
+        walked += ranges[generating].second - ranges[generating].first;
+        generating++;
+    }
+
+    QVector<quint32> ids;
+    ids.reserve(int(walked));
+    for (int r = 0; r < generating; ++r) {
+        for (quint32 i = ranges[r].first; i < ranges[r].second; ++i) {
+            quint32 id = postings[i];
+            int length = source_lengths[int(id)];
+            if (length >= query_length * min_similarity && length <= max_length) {
+                ids << id;
+            }
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    // {shared trigrams, id}
+    QVector<QPair<int, quint32>> candidates;
+    for (int i = 0; i < ids.size();) {
+        int j = i + 1;
+        while (j < ids.size() && ids[j] == ids[i]) {
+            ++j;
+        }
+        candidates << qMakePair(j - i, ids[i]);
+        i = j;
+    }
+    auto more_shared = [](const QPair<int, quint32> &a, const QPair<int, quint32> &b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    if (candidates.size() > max_probed_candidates) {
+        std::nth_element(candidates.begin(), candidates.begin() + max_probed_candidates, candidates.end(), more_shared);
+        candidates.resize(max_probed_candidates);
+    }
+
+    // Complete the counts with binary searches in the lists that were not
+    // walked (postings of one trigram are sorted by id), dropping candidates
+    // as soon as they can no longer reach the threshold.
+    QVector<QPair<int, quint32>> counted;
+    counted.reserve(candidates.size());
+    for (QPair<int, quint32> candidate : candidates) {
+        for (int r = generating; r < ranges.size(); ++r) {
+            if (candidate.first + int(ranges.size()) - r < threshold) {
+                break;
+            }
+            const quint32 *begin = postings.constData() + ranges[r].first;
+            const quint32 *end = postings.constData() + ranges[r].second;
+            const quint32 *it = std::lower_bound(begin, end, candidate.second);
+            if (it != end && *it == candidate.second) {
+                candidate.first++;
+            }
+        }
+        if (candidate.first >= threshold) {
+            counted << candidate;
+        }
+    }
+    if (counted.size() > max_verified_candidates) {
+        std::nth_element(counted.begin(), counted.begin() + max_verified_candidates, counted.end(), more_shared);
+        counted.resize(max_verified_candidates);
+    }
+    candidates = counted;
+
+    MyersPattern pattern(reinterpret_cast<const char16_t *>(query.utf16()), query_length);
+    for (const auto &candidate : candidates) {
+        QString normalized = normalize(sources[int(candidate.second)]);
+        int distance = pattern.distance(reinterpret_cast<const char16_t *>(normalized.utf16()), int(normalized.size()));
+        double similarity = 1.0 - double(distance) / double(qMax(query_length, int(normalized.size())));
+        if (similarity >= min_similarity) {
+            suggestions << Suggestion{sources[int(candidate.second)], targets[int(candidate.second)], similarity, distance};
+        }
+    }
+
+    std::sort(suggestions.begin(), suggestions.end(), [](const Suggestion &a, const Suggestion &b) {
+        return a.similarity != b.similarity ? a.similarity > b.similarity : a.source < b.source;
+    });
+    if (suggestions.size() > max_results) {
+        suggestions.resize(max_results);
+    }
+    return suggestions;
+}
+
+int TranslationMemory::edit_distance(const char16_t *pattern, int pattern_length, const char16_t *text, int text_length) {
+    return MyersPattern(pattern, pattern_length).distance(text, text_length);
+}
+
+int TranslationMemory::edit_distance(const QString &a, const QString &b) {
+    return edit_distance(reinterpret_cast<const char16_t *>(a.utf16()), int(a.size()),
+                         reinterpret_cast<const char16_t *>(b.utf16()), int(b.size()));
+}
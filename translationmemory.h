@@ -0,0 +1,54 @@
+#ifndef TRANSLATIONMEMORY_H
+#define TRANSLATIONMEMORY_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include "locasnapshot.h"
+
+// Source/target string pairs from every scanned mod, with fuzzy lookup for
+// new or changed source strings. Candidates come from a trigram index
+// (only the rarest trigrams of the query are walked, the rest are probed per
+// candidate), and are then ranked by exact edit distance using Myers'
+// bit-parallel algorithm.
+class TranslationMemory {
+public:
+    struct Suggestion {
+        QString source;
+        QString target;
+        double similarity;
+        int distance;
+    };
+
+    TranslationMemory();
+    void clear();
+    // Pairs up every contentuid present in both languages of the snapshot.
+    void build(const LocaSnapshot &snapshot, const QString &source_language, const QString &target_language);
+    void add(const QString &source, const QString &target);
+    // Builds the trigram index, call after the last add().
+    void finalize();
+    int size() const;
+
+    QVector<Suggestion> lookup(const QString &text, int max_results = 5, double min_similarity = 0.6) const;
+
+    static QString normalize(const QString &text);
+    static int edit_distance(const QString &a, const QString &b);
+    static int edit_distance(const char16_t *pattern, int pattern_length, const char16_t *text, int text_length);
+
+private:
+    static void trigrams(const QString &normalized, QVector<quint64> &grams);
+
+    QVector<QString> sources;
+    QVector<QString> targets;
+    QVector<int> source_lengths;  // normalized, used as a cheap length filter
+    QSet<QPair<QString, QString>> seen_pairs;
+
+    // Posting lists stored flat: entries of grams[i] are postings[offsets[i]..offsets[i+1])
+    QVector<quint64> grams;
+    QVector<quint32> offsets;
+    QVector<quint32> postings;
+};
+
+#endif
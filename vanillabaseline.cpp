@@ -0,0 +1,282 @@
+#include "vanillabaseline.h"
+#include "duplicatestrings.h"
+#include "localizationfile.h"
+#include "lspkreader.h"
+#include <QDirIterator>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct BaselineEntry {
+    quint64 key;
+    quint32 text;
+    quint16 version;
+    int package;
+
+    bool operator<(const BaselineEntry &other) const {
+        return key != other.key ? key < other.key : package < other.package;
+    }
+};
+
+}
+
+VanillaBaseline::VanillaBaseline() : data(nullptr), size(0), language_count(0), total_entries(0) {
+}
+
+VanillaBaseline::~VanillaBaseline() {
+    close();
+}
+
+quint64 VanillaBaseline::key_hash(QByteArrayView key) {
+    return DuplicateStrings::hash(key.data(), key.size());
+}
+
+quint32 VanillaBaseline::text_hash(QByteArrayView text) {
+    quint64 h = DuplicateStrings::hash(text.data(), text.size());
+    return quint32(h ^ (h >> 32));
+}
+
+bool VanillaBaseline::build(const QString &data_dir, const QString &output_path, QString &error, int *strings) {
+    QStringList paks;
+    QDirIterator it(data_dir + "/Localization", QStringList() << "*.pak", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString pak = it.next();
+        if (LspkReader::main_part_for(pak).isEmpty()) {
+            paks << pak;
+        }
+    }
+    if (paks.isEmpty()) {
+        error = "No localization packages found under " + data_dir + "/Localization";
+        return false;
+    }
+    paks.sort();
+
+    // Packages are independent, so read and parse them in parallel
+    QMutex mutex;
+    QMap<QString, QVector<BaselineEntry>> sections;
+    QStringList failures;
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    for (int package = 0; package < paks.size(); ++package) {
+        QString pak = paks[package];
+        pool.start([&, pak, package]() {
+            LspkReader reader(pak);
+            if (!reader.open()) {
+                QMutexLocker locker(&mutex);
+                failures << reader.error_string();
+                return;
+            }
+            QMap<QString, QVector<BaselineEntry>> local;
+            for (const LspkReader::Entry &entry : reader.entries()) {
+                QStringList parts = entry.name.split('/');
+                if (parts.size() < 3 || parts[0] != "Localization" || !LocalizationFile::is_localization_file(entry.name)) {
+                    continue;
+                }
+                QByteArray contents = reader.read_entry(entry);
+                QVector<LocalizationFile::Entry> entries;
+                QString parse_error;
+                bool parsed = !contents.isNull() && (entry.name.endsWith(".loca", Qt::CaseInsensitive)
+                                                         ? LocalizationFile::read_loca(contents, entries, parse_error)
+                                                         : LocalizationFile::read_xml(contents, entries, parse_error));
+                if (!parsed) {
+                    QMutexLocker locker(&mutex);
+                    failures << entry.name + ": " + (contents.isNull() ? reader.error_string() : parse_error);
+                    continue;
+                }
+                QVector<BaselineEntry> &section = local[parts[1]];
+                for (const LocalizationFile::Entry &string : entries) {
+                    section << BaselineEntry{key_hash(string.key), text_hash(string.text.toUtf8()), string.version, package};
+                }
+            }
+
+            QMutexLocker locker(&mutex);
+            for (auto section = local.begin(); section != local.end(); ++section) {
+                sections[section.key()] += section.value();
+            }
+        });
+    }
+    pool.waitForDone();
+
+    if (sections.isEmpty()) {
+        error = failures.isEmpty() ? "No localization strings found" : failures.first();
+        return false;
+    }
+
+    QByteArray languages(qint64(sections.size()) * language_record_size, '\0');
+    QByteArray entries;
+    quint32 first = 0;
+    int index = 0;
+    for (auto section = sections.begin(); section != sections.end(); ++section, ++index) {
+        QVector<BaselineEntry> &list = section.value();
+        // For keys defined more than once the package sorting last wins
+        std::sort(list.begin(), list.end());
+        QVector<BaselineEntry> unique;
+        unique.reserve(list.size());
+        for (const BaselineEntry &entry : list) {
+            if (!unique.isEmpty() && unique.last().key == entry.key) {
+                unique.last() = entry;
+            } else {
+                unique << entry;
+            }
+        }
+
+        uchar *record = reinterpret_cast<uchar *>(languages.data()) + qint64(index) * language_record_size;
+        QByteArray name = section.key().toUtf8().left(name_size - 1);
+        memcpy(record, name.constData(), size_t(name.size()));
+        qToLittleEndian<quint32>(first, record + name_size);
+        qToLittleEndian<quint32>(quint32(unique.size()), record + name_size + 4);
+
+        QByteArray block(qint64(unique.size()) * entry_size, '\0');
+        uchar *p = reinterpret_cast<uchar *>(block.data());
+        for (const BaselineEntry &entry : unique) {
+            qToLittleEndian<quint64>(entry.key, p);
+            qToLittleEndian<quint32>(entry.text, p + 8);
+            qToLittleEndian<quint16>(entry.version, p + 12);
+            p += entry_size;
+        }
+        entries += block;
+        first += quint32(unique.size());
+    }
+
+    uchar header[header_size];
+    qToLittleEndian<quint32>(magic, header);
+    qToLittleEndian<quint32>(format_version, header + 4);
+    qToLittleEndian<quint32>(quint32(sections.size()), header + 8);
+    qToLittleEndian<quint32>(first, header + 12);
+
+    QSaveFile output(output_path);
+    if (!output.open(QIODevice::WriteOnly)) {
+        error = "Unable to write " + output_path + ": " + output.errorString();
+        return false;
+    }
+    output.write(reinterpret_cast<const char *>(header), header_size);
+    output.write(languages);
+    output.write(entries);
+    if (!output.commit()) {
+        error = "Unable to write " + output_path + ": " + output.errorString();
+        return false;
+    }
+    if (strings) {
+        *strings = int(first);
+    }
+    return true;
+}
+
+bool VanillaBaseline::open(const QString &path) {
+    QWriteLocker locker(&lock);
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+    }
+    file.close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    size = file.size();
+    data = size >= header_size ? file.map(0, size) : nullptr;
+    if (!data) {
+        file.close();
+        return false;
+    }
+
+    language_count = qFromLittleEndian<quint32>(data + 8);
+    total_entries = qFromLittleEndian<quint32>(data + 12);
+    bool valid = qFromLittleEndian<quint32>(data) == magic && qFromLittleEndian<quint32>(data + 4) == format_version
+                 && header_size + quint64(language_count) * language_record_size + quint64(total_entries) * entry_size <= quint64(size);
+    for (quint32 l = 0; valid && l < language_count; ++l) {
+        const uchar *record = data + header_size + quint64(l) * language_record_size;
+        valid = quint64(qFromLittleEndian<quint32>(record + name_size)) + qFromLittleEndian<quint32>(record + name_size + 4) <= total_entries;
+    }
+    if (!valid) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+void VanillaBaseline::close() {
+    QWriteLocker locker(&lock);
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+    }
+    file.close();
+    language_count = 0;
+    total_entries = 0;
+}
+
+bool VanillaBaseline::is_open() const {
+    QReadLocker locker(&lock);
+    return data != nullptr;
+}
+
+QStringList VanillaBaseline::languages() const {
+    QReadLocker locker(&lock);
+    QStringList names;
+    for (quint32 l = 0; data && l < language_count; ++l) {
+        const char *record = reinterpret_cast<const char *>(data + header_size + quint64(l) * language_record_size);
+        names << QString::fromUtf8(record, qstrnlen(record, name_size));
+    }
+    return names;
+}
+
+int VanillaBaseline::entry_count() const {
+    QReadLocker locker(&lock);
+    return int(total_entries);
+}
+
+const uchar *VanillaBaseline::find(const QString &language, QByteArrayView key) const {
+    QByteArray name = language.toUtf8();
+    const uchar *entries = data + header_size + quint64(language_count) * language_record_size;
+    for (quint32 l = 0; data && l < language_count; ++l) {
+        const char *record = reinterpret_cast<const char *>(data + header_size + quint64(l) * language_record_size);
+        if (qstrnlen(record, name_size) != size_t(name.size()) || memcmp(record, name.constData(), size_t(name.size())) != 0) {
+            continue;
+        }
+
+        quint64 hash = key_hash(key);
+        quint32 first = qFromLittleEndian<quint32>(record + name_size);
+        quint32 count = qFromLittleEndian<quint32>(record + name_size + 4);
+        quint32 end = first + count;
+        while (count > 0) {
+            quint32 step = count / 2;
+            if (qFromLittleEndian<quint64>(entries + quint64(first + step) * entry_size) < hash) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        const uchar *entry = entries + quint64(first) * entry_size;
+        if (first < end && qFromLittleEndian<quint64>(entry) == hash) {
+            return entry;
+        }
+        return nullptr;
+    }
+    return nullptr;
+}
+
+bool VanillaBaseline::contains(const QString &language, QByteArrayView key) const {
+    QReadLocker locker(&lock);
+    return data && find(language, key) != nullptr;
+}
+
+bool VanillaBaseline::differs(const QString &language, QByteArrayView key, QByteArrayView text) const {
+    QReadLocker locker(&lock);
+    const uchar *entry = data ? find(language, key) : nullptr;
+    return !entry || qFromLittleEndian<quint32>(entry + 8) != text_hash(text);
+}
@@ -0,0 +1,63 @@
+#ifndef VANILLABASELINE_H
+#define VANILLABASELINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QReadWriteLock>
+
+// Which contentuids the base game itself defines, per language. Built once
+// from the game's Localization/*.pak with the native package reader and kept
+// as a memory-mapped table of hashed keys, so checking whether a mod string
+// overrides vanilla is a binary search instead of a pass over gigabytes of
+// game data.
+//
+// Layout (little endian):
+//   header    magic "DMTB", version, language count, entry count
+//   languages {name[32], first entry, entry count} each
+//   entries   {key hash u64, text hash u32, version u16, reserved u16},
+//             sorted by key hash within each language
+class VanillaBaseline {
+public:
+    VanillaBaseline();
+    ~VanillaBaseline();
+    VanillaBaseline(const VanillaBaseline &) = delete;
+    VanillaBaseline &operator=(const VanillaBaseline &) = delete;
+
+    // Indexes every localization file in the packages under data_dir.
+    static bool build(const QString &data_dir, const QString &output_path, QString &error, int *strings = nullptr);
+
+    bool open(const QString &path);
+    void close();
+    bool is_open() const;
+
+    QStringList languages() const;
+    int entry_count() const;
+    bool contains(const QString &language, QByteArrayView key) const;
+    // True if the text differs from vanilla, or the key is not vanilla at all.
+    bool differs(const QString &language, QByteArrayView key, QByteArrayView text) const;
+
+    static quint64 key_hash(QByteArrayView key);
+    static quint32 text_hash(QByteArrayView text);
+
+    static const quint32 magic = 0x424d5444;  // "DMTB"
+    static const quint32 format_version = 1;
+    static const int header_size = 16;
+    static const int name_size = 32;
+    static const int language_record_size = name_size + 8;
+    static const int entry_size = 16;
+
+private:
+    const uchar *find(const QString &language, QByteArrayView key) const;
+
+    mutable QReadWriteLock lock;
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    quint32 language_count;
+    quint32 total_entries;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "vortexdeployment.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+static const char *staging_marker = "__folder_managed_by_vortex";
+
+bool VortexDeployment::read(const QString &manifest_path) {
+    staging.clear();
+    target.clear();
+    file_list.clear();
+
+    QFile file(manifest_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Unable to open " + manifest_path + ": " + file.errorString();
+        return false;
+    }
+
+    QJsonParseError parse_error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parse_error);
+    if (!document.isObject()) {
+        error = "Invalid deployment manifest " + manifest_path + ": " + parse_error.errorString();
+        return false;
+    }
+
+    QJsonObject manifest = document.object();
+    staging = manifest["stagingPath"].toString();
+    target = manifest["targetPath"].toString();
+    const QJsonArray files = manifest["files"].toArray();
+    file_list.reserve(files.size());
+    for (const QJsonValue &value : files) {
+        QJsonObject entry = value.toObject();
+        File deployed;
+        deployed.rel_path = QDir::fromNativeSeparators(entry["relPath"].toString());
+        deployed.source = entry["source"].toString();
+        if (!deployed.rel_path.isEmpty() && !deployed.source.isEmpty()) {
+            file_list << deployed;
+        }
+    }
+    error.clear();
+    return true;
+}
+
+QString VortexDeployment::error_string() const {
+    return error;
+}
+
+QString VortexDeployment::staging_path() const {
+    return staging;
+}
+
+QString VortexDeployment::target_path() const {
+    return target;
+}
+
+const QVector<VortexDeployment::File> &VortexDeployment::files() const {
+    return file_list;
+}
+
+QStringList VortexDeployment::deployed_mods(const QString &staging_folder) const {
+    QString root = staging_folder.isEmpty() ? staging : staging_folder;
+    QStringList mods;
+    QSet<QString> seen;
+    for (const File &deployed : file_list) {
+        if (!seen.contains(deployed.source)) {
+            seen.insert(deployed.source);
+            mods << QDir::cleanPath(root + "/" + deployed.source);
+        }
+    }
+    return mods;
+}
+
+bool VortexDeployment::is_staging_folder(const QString &folder) {
+    return QFileInfo::exists(folder + "/" + staging_marker);
+}
+
+QString VortexDeployment::find_manifest(const QString &folder) {
+    // vortex.deployment.json, or vortex.deployment.<mod type>.json
+    QStringList manifests = QDir(folder).entryList(QStringList() << "vortex.deployment*.json", QDir::Files, QDir::Name);
+    return manifests.isEmpty() ? QString() : QDir(folder).filePath(manifests.first());
+}
+
+QStringList VortexDeployment::scan_items(const QString &folder, QString *error) {
+    QString manifest_path = find_manifest(folder);
+    VortexDeployment deployment;
+    bool has_manifest = !manifest_path.isEmpty() && deployment.read(manifest_path);
+    if (!manifest_path.isEmpty() && !has_manifest && error) {
+        *error = deployment.error_string();
+    }
+
+    if (is_staging_folder(folder)) {
+        if (has_manifest) {
+            return deployment.deployed_mods(folder);
+        }
+        // Nothing says what is deployed, every staged mod counts
+        QStringList mods;
+        for (const QString &mod : QDir(folder).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+            mods << QDir::cleanPath(folder + "/" + mod);
+        }
+        return mods;
+    }
+
+    if (has_manifest && !deployment.staging_path().isEmpty()) {
+        // A deployment target: scan the staged originals, and only the paks
+        // Vortex did not put here directly.
+        QStringList items = deployment.deployed_mods();
+        QSet<QString> managed;
+        for (const File &deployed : deployment.files()) {
+            managed.insert(deployed.rel_path.toLower());
+        }
+        QDir dir(folder);
+        for (const QString &pak : dir.entryList(QStringList() << "*.pak", QDir::Files, QDir::Name)) {
+            if (!managed.contains(pak.toLower())) {
+                items << dir.filePath(pak);
+            }
+        }
+        return items;
+    }
+
+    return QStringList() << folder;
+}
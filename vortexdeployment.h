@@ -0,0 +1,40 @@
+#ifndef VORTEXDEPLOYMENT_H
+#define VORTEXDEPLOYMENT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Vortex keeps every mod unpacked in a staging folder (marked by
+// __folder_managed_by_vortex) and deploys the files into the game folder,
+// usually as hardlinks, recording what went where in vortex.deployment*.json.
+class VortexDeployment {
+public:
+    struct File {
+        QString rel_path;
+        QString source;  // mod folder name inside the staging folder
+    };
+
+    bool read(const QString &manifest_path);
+    QString error_string() const;
+    QString staging_path() const;
+    QString target_path() const;
+    const QVector<File> &files() const;
+    // Staging folders of the mods that are deployed, without duplicates.
+    QStringList deployed_mods(const QString &staging_folder = QString()) const;
+
+    static bool is_staging_folder(const QString &folder);
+    static QString find_manifest(const QString &folder);
+    // What to scan for a folder given on the command line or by the UI: the
+    // deployed mods for a staging or deployment folder (plus paks in the
+    // deployment folder Vortex does not manage), otherwise the folder itself.
+    static QStringList scan_items(const QString &folder, QString *error = nullptr);
+
+private:
+    QString staging;
+    QString target;
+    QVector<File> file_list;
+    QString error;
+};
+
+#endif
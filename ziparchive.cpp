@@ -0,0 +1,227 @@
+#include "ziparchive.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <zlib.h>
+
+static const quint32 local_header_signature = 0x04034b50;
+static const quint32 central_header_signature = 0x02014b50;
+static const quint32 end_of_directory_signature = 0x06054b50;
+static const qint64 end_of_directory_size = 22;
+static const qint64 output_chunk_size = 256 * 1024;
+
+static quint16 read_u16(const uchar *p) {
+    return qFromLittleEndian<quint16>(p);
+}
+
+static quint32 read_u32(const uchar *p) {
+    return qFromLittleEndian<quint32>(p);
+}
+
+ZipArchive::ZipArchive(const QString &path) : file(path), data(nullptr), size(0) {
+}
+
+ZipArchive::~ZipArchive() {
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+    }
+}
+
+QString ZipArchive::error_string() const {
+    return error;
+}
+
+const QVector<ZipArchive::Entry> &ZipArchive::entries() const {
+    return entry_list;
+}
+
+bool ZipArchive::open() {
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Unable to open " + file.fileName() + ": " + file.errorString();
+        return false;
+    }
+    size = file.size();
+    data = file.map(0, size);
+    if (!data) {
+        error = "Unable to map " + file.fileName() + ": " + file.errorString();
+        return false;
+    }
+    return read_central_directory();
+}
+
+bool ZipArchive::read_central_directory() {
+    // The end of central directory record sits in the last 22 bytes plus an
+    // optional comment of up to 64 KB.
+    qint64 eocd = -1;
+    qint64 lowest = qMax<qint64>(0, size - end_of_directory_size - 0xFFFF);
+    for (qint64 pos = size - end_of_directory_size; pos >= lowest; --pos) {
+        if (read_u32(data + pos) == end_of_directory_signature) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        error = file.fileName() + " is not a zip archive";
+        return false;
+    }
+
+    quint16 count = read_u16(data + eocd + 10);
+    quint32 directory_size = read_u32(data + eocd + 12);
+    quint32 directory_offset = read_u32(data + eocd + 16);
+    if (directory_offset == 0xFFFFFFFF || qint64(directory_offset) + directory_size > eocd) {
+        error = file.fileName() + ": zip64 or corrupt central directory is not supported";
+        return false;
+    }
+
+    entry_list.clear();
+    entry_list.reserve(count);
+    qint64 pos = directory_offset;
+    for (quint16 i = 0; i < count; ++i) {
+        if (pos + 46 > eocd || read_u32(data + pos) != central_header_signature) {
+            error = file.fileName() + ": corrupt central directory";
+            return false;
+        }
+        quint16 name_length = read_u16(data + pos + 28);
+        quint16 extra_length = read_u16(data + pos + 30);
+        quint16 comment_length = read_u16(data + pos + 32);
+        qint64 record_size = 46 + qint64(name_length) + extra_length + comment_length;
+        if (pos + record_size > eocd) {
+            error = file.fileName() + ": corrupt central directory";
+            return false;
+        }
+
+        Entry entry;
+        entry.method = read_u16(data + pos + 10);
+        entry.crc32 = read_u32(data + pos + 16);
+        entry.compressed_size = read_u32(data + pos + 20);
+        entry.uncompressed_size = read_u32(data + pos + 24);
+        entry.local_header_offset = read_u32(data + pos + 42);
+        entry.name = QString::fromUtf8(reinterpret_cast<const char *>(data + pos + 46), name_length);
+        entry_list << entry;
+
+        pos += record_size;
+    }
+    return true;
+}
+
+bool ZipArchive::extract(const QVector<Entry> &members, const QString &strip_prefix, const QString &destination, int max_threads) {
+    QDir destination_dir(destination);
+    QString root = QDir::cleanPath(destination_dir.absolutePath());
+
+    QVector<QPair<Entry, QString>> jobs;
+    for (const Entry &entry : members) {
+        if (entry.name.endsWith('/')) {
+            continue;  // Directories are created on demand
+        }
+        QString relative = entry.name.startsWith(strip_prefix) ? entry.name.mid(strip_prefix.size()) : entry.name;
+        QString target = QDir::cleanPath(root + "/" + relative);
+        if (!target.startsWith(root + "/")) {
+            error = "Refusing to extract " + entry.name + " outside of " + root;
+            return false;
+        }
+        QDir().mkpath(QFileInfo(target).absolutePath());
+        jobs << qMakePair(entry, target);
+    }
+
+    QThreadPool pool;
+    if (max_threads > 0) {
+        pool.setMaxThreadCount(max_threads);
+    }
+
+    QMutex error_mutex;
+    QStringList errors;
+    for (const auto &job : jobs) {
+        pool.start([this, job, &error_mutex, &errors]() {
+            QString job_error;
+            if (!extract_entry(job.first, job.second, job_error)) {
+                QMutexLocker locker(&error_mutex);
+                errors << job_error;
+            }
+        });
+    }
+    pool.waitForDone();
+
+    if (!errors.isEmpty()) {
+        error = errors.join("; ");
+        return false;
+    }
+    return true;
+}
+
+bool ZipArchive::extract_entry(const Entry &entry, const QString &target_path, QString &entry_error) const {
+    qint64 header = entry.local_header_offset;
+    if (header + 30 > size || read_u32(data + header) != local_header_signature) {
+        entry_error = entry.name + ": corrupt local header";
+        return false;
+    }
+    qint64 start = header + 30 + read_u16(data + header + 26) + read_u16(data + header + 28);
+    if (start + entry.compressed_size > size) {
+        entry_error = entry.name + ": truncated member";
+        return false;
+    }
+    const uchar *compressed = data + start;
+
+    QFile output(target_path);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        entry_error = "Unable to create " + target_path + ": " + output.errorString();
+        return false;
+    }
+    // Reserve the full size up front so the filesystem can lay the file out in one go.
+    output.resize(entry.uncompressed_size);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    if (entry.method == 0) {
+        if (output.write(reinterpret_cast<const char *>(compressed), entry.compressed_size) != entry.compressed_size) {
+            entry_error = "Error writing " + target_path + ": " + output.errorString();
+            return false;
+        }
+        crc = crc32_z(crc, compressed, size_t(entry.compressed_size));
+    } else if (entry.method == 8) {
+        z_stream stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            entry_error = entry.name + ": unable to initialise inflate";
+            return false;
+        }
+        QByteArray chunk(output_chunk_size, Qt::Uninitialized);
+        stream.next_in = const_cast<Bytef *>(compressed);
+        stream.avail_in = uInt(entry.compressed_size);
+        int status = Z_OK;
+        while (status != Z_STREAM_END) {
+            stream.next_out = reinterpret_cast<Bytef *>(chunk.data());
+            stream.avail_out = uInt(chunk.size());
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END) {
+                inflateEnd(&stream);
+                entry_error = entry.name + ": corrupt deflate stream";
+                return false;
+            }
+            qint64 produced = chunk.size() - stream.avail_out;
+            if (produced == 0 && status != Z_STREAM_END) {
+                inflateEnd(&stream);
+                entry_error = entry.name + ": truncated deflate stream";
+                return false;
+            }
+            if (output.write(chunk.constData(), produced) != produced) {
+                inflateEnd(&stream);
+                entry_error = "Error writing " + target_path + ": " + output.errorString();
+                return false;
+            }
+            crc = crc32(crc, reinterpret_cast<const Bytef *>(chunk.constData()), uInt(produced));
+        }
+        inflateEnd(&stream);
+    } else {
+        entry_error = entry.name + QString(": unsupported compression method %1").arg(entry.method);
+        return false;
+    }
+
+    if (crc != entry.crc32) {
+        output.close();
+        QFile::remove(target_path);
+        entry_error = entry.name + ": CRC mismatch";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+
+// Minimal in-process reader for .zip archives (stored and deflated members,
+// no zip64). The archive is memory mapped once and members are inflated in
+// parallel straight into preallocated output files.
+class ZipArchive {
+public:
+    struct Entry {
+        QString name;
+        quint16 method;
+        quint32 crc32;
+        qint64 compressed_size;
+        qint64 uncompressed_size;
+        qint64 local_header_offset;
+    };
+
+    explicit ZipArchive(const QString &path);
+    ~ZipArchive();
+
+    bool open();
+    QString error_string() const;
+    const QVector<Entry> &entries() const;
+
+    // Extracts the given members below destination, with strip_prefix removed
+    // from their names. Uses up to max_threads workers (0 = one per core).
+    bool extract(const QVector<Entry> &members, const QString &strip_prefix, const QString &destination, int max_threads = 0);
+
+private:
+    bool read_central_directory();
+    bool extract_entry(const Entry &entry, const QString &target_path, QString &error) const;
+
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    QVector<Entry> entry_list;
+    QString error;
+};
+
+#endif